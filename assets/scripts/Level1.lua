@@ -102,6 +102,21 @@ Level = {
 		scale = 2.0
 	},
 
+	----------------------------------------------------
+	-- table to define the collision settings
+	----------------------------------------------------
+	collision = {
+		broadphase = "grid", -- "grid" (spatial hash rebuilt every frame) or "tree" (persistent AABB trees)
+		cell_size = 64, -- grid cell size, in pixels
+		-- pairs of collision layers (gameplay tags) that are tested against each other
+		interactions = {
+			[0] =
+			{ layer = "Enemies",     collides_with = "Obstacles" },
+			{ layer = "Projectiles", collides_with = "Player" },
+			{ layer = "Projectiles", collides_with = "Enemies" }
+		}
+	},
+
 	----------------------------------------------------
 	-- table to define entities and their components
 	----------------------------------------------------
@@ -2814,6 +2829,29 @@ Level = {
 							set_projectile_velocity(entity, 0, 200) -- shoot projectiles down
 						end
 					end
+				},
+				-- collision hooks run once when a contact begins and once when it ends
+				on_collision_enter = {
+					[0] =
+					function(entity, other)
+						-- a projectile hit staggers the jet, halving its speed while the contact lasts
+						if other:belongs_to_group("Projectiles") then
+							local current_velocity_x, current_velocity_y = get_velocity(entity)
+							set_velocity(entity, 0, current_velocity_y * 0.5)
+						end
+					end
+				},
+				on_collision_exit = {
+					[0] =
+					function(entity, other)
+						-- back to cruising speed, keeping the current direction
+						local current_velocity_x, current_velocity_y = get_velocity(entity)
+						if current_velocity_y < 0 then
+							set_velocity(entity, 0, -50)
+						else
+							set_velocity(entity, 0, 50)
+						end
+					end
 				}
 			}
 		},
@@ -75,7 +75,8 @@ Level = {
 		{ type = "texture", id = "bullet-texture",              file = "./assets/images/bullet.png" },
 		{ type = "texture", id = "radar-texture",               file = "./assets/images/radar-spritesheet.png" },
 		{ type = "font"   , id = "pico8-font-5",                file = "./assets/fonts/pico8.ttf", font_size = 5 },
-		{ type = "font"   , id = "pico8-font-10",               file = "./assets/fonts/pico8.ttf", font_size = 10 }
+		{ type = "font"   , id = "pico8-font-10",               file = "./assets/fonts/pico8.ttf", font_size = 10 },
+		{ type = "sound"  , id = "helicopter-sound",            file = "./assets/sounds/helicopter.wav" }
 	},
 
 	----------------------------------------------------
@@ -90,6 +91,35 @@ Level = {
 		scale = 2.0
 	},
 
+	----------------------------------------------------
+	-- table to define the collision settings
+	----------------------------------------------------
+	collision = {
+		broadphase = "grid", -- "grid" (spatial hash rebuilt every frame) or "tree" (persistent AABB trees)
+		cell_size = 64, -- grid cell size, in pixels
+		-- pairs of collision layers (gameplay tags) that are tested against each other
+		interactions = {
+			[0] =
+			{ layer = "Enemies",     collides_with = "Obstacles" },
+			{ layer = "Projectiles", collides_with = "Player" },
+			{ layer = "Projectiles", collides_with = "Enemies" }
+		}
+	},
+
+	----------------------------------------------------
+	-- table to define the projectile settings
+	----------------------------------------------------
+	projectiles = {
+		pool_size = 256 -- projectile entities created up front; the pool doubles when it runs out
+	},
+
+	----------------------------------------------------
+	-- table to define the particle settings
+	----------------------------------------------------
+	particles = {
+		pool_capacity = 16384 -- live particles per texture; more are dropped
+	},
+
 	----------------------------------------------------
 	-- table to define entities and their components
 	----------------------------------------------------
@@ -139,6 +169,20 @@ Level = {
 				},
 				camera_follow = {
 					follow = true
+				},
+				particle_bursts = {
+					-- muzzle flash every time the projectile emitter fires
+					on_fire = {
+						count = 12,
+						texture_asset_id = "bullet-texture",
+						lifetime = 0.15, -- seconds
+						lifetime_variance = 0.1,
+						speed = 80, -- pixels per second
+						speed_variance = 60,
+						spread = 360, -- degrees
+						size = 3,
+						color = { r = 255, g = 220, b = 120 }
+					}
 				}
 			}
 		},
@@ -357,6 +401,32 @@ Level = {
 					repeat_frequency = 3, -- seconds
 					hit_percentage_damage = 5,
 					friendly = false
+				},
+				particle_emitter = {
+					-- smoke
+					rate = 6, -- particles per second
+					texture_asset_id = "bullet-texture",
+					lifetime = 2.0, -- seconds
+					lifetime_variance = 0.5,
+					speed = 12, -- pixels per second
+					speed_variance = 6,
+					direction = 270, -- degrees, clockwise from the right
+					spread = 40, -- degrees
+					size = 6,
+					color = { r = 90, g = 90, b = 90, a = 160 }
+				},
+				particle_bursts = {
+					-- explosion when destroyed
+					on_destroy = {
+						count = 80,
+						texture_asset_id = "bullet-texture",
+						lifetime = 0.6, -- seconds
+						lifetime_variance = 0.4,
+						speed = 90, -- pixels per second
+						speed_variance = 80,
+						size = 5,
+						color = { r = 255, g = 140, b = 40 }
+					}
 				}
 			}
 		},
@@ -2531,6 +2601,7 @@ Level = {
 						-- if it reaches the top or the bottom of the map
 						if current_position_y < 10  or current_position_y > map_height - 32 then
 							set_velocity(entity, 0, current_velocity_y * -1); -- flip the entity y-velocity
+							play_sound("helicopter-sound", { x = current_position_x, y = current_position_y, volume = 0.6 })
 						else
 							set_velocity(entity, 0, current_velocity_y); -- do not flip y-velocity
 						end
@@ -0,0 +1,178 @@
+#include "../src/Collision/AABB.hpp"
+#include "../src/Collision/AABBTree.hpp"
+#include "../src/Collision/SpatialHashGrid.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using PairList = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// Boxes between 4 and 32 pixels spread over a square world whose area grows with the
+// collider count, so the number of overlaps per collider stays roughly constant.
+static std::vector<AABB> MakeScene(uint32_t ColliderCount)
+{
+	std::mt19937 Generator(1234);
+	const float WorldSize = std::sqrt(static_cast<float>(ColliderCount)) * 40.0f;
+	std::uniform_real_distribution<float> Position(0.0f, WorldSize);
+	std::uniform_real_distribution<float> Size(4.0f, 32.0f);
+
+	std::vector<AABB> Bounds;
+	Bounds.reserve(ColliderCount);
+	for (uint32_t i = 0; i < ColliderCount; ++i)
+	{
+		const float X = Position(Generator);
+		const float Y = Position(Generator);
+		Bounds.emplace_back(X, Y, X + Size(Generator), Y + Size(Generator));
+	}
+	return Bounds;
+}
+
+static void FindPairsNestedLoop(const std::vector<AABB>& Bounds, PairList& OutPairs)
+{
+	for (uint32_t A = 0; A < Bounds.size(); ++A)
+	{
+		for (uint32_t B = A + 1; B < Bounds.size(); ++B)
+		{
+			if (Bounds[A].Overlaps(Bounds[B]))
+			{
+				OutPairs.emplace_back(A, B);
+			}
+		}
+	}
+}
+
+template <typename Function>
+static double MeasureMilliseconds(uint32_t Iterations, Function&& Body)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < Iterations; ++i)
+	{
+		Body();
+	}
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	return Elapsed.count() / Iterations;
+}
+
+// Mirrors the engine's worker split: every thread queries the tree for its own slice of bodies
+// into a private buffer, then the buffers are merged and sorted into a deterministic order.
+static void FindPairsParallel(const AABBTree& Tree, const std::vector<int32_t>& Proxies, uint32_t ThreadCount, std::vector<PairList>& WorkerPairs, PairList& OutPairs)
+{
+	WorkerPairs.resize(ThreadCount);
+	std::vector<std::thread> Workers;
+	for (uint32_t Worker = 0; Worker < ThreadCount; ++Worker)
+	{
+		Workers.emplace_back([&, Worker]()
+		{
+			PairList& Pairs = WorkerPairs[Worker];
+			Pairs.clear();
+			const size_t Begin = Proxies.size() * Worker / ThreadCount;
+			const size_t End = Proxies.size() * (Worker + 1) / ThreadCount;
+			for (size_t i = Begin; i < End; ++i)
+			{
+				const AABB& Bounds = Tree.GetBounds(Proxies[i]);
+				const uint32_t Self = static_cast<uint32_t>(Tree.GetUserData(Proxies[i]));
+				Tree.Query(Bounds, CollisionLayer::All, [&](int32_t Other)
+				{
+					const uint32_t OtherID = static_cast<uint32_t>(Tree.GetUserData(Other));
+					if (OtherID > Self && Bounds.Overlaps(Tree.GetBounds(Other)))
+					{
+						Pairs.emplace_back(Self, OtherID);
+					}
+				});
+			}
+		});
+	}
+
+	for (auto& Worker : Workers)
+	{
+		Worker.join();
+	}
+
+	OutPairs.clear();
+	for (const PairList& Pairs : WorkerPairs)
+	{
+		OutPairs.insert(OutPairs.end(), Pairs.begin(), Pairs.end());
+	}
+	std::sort(OutPairs.begin(), OutPairs.end());
+}
+
+static void RunThreadScaling(uint32_t ColliderCount)
+{
+	const std::vector<AABB> Bounds = MakeScene(ColliderCount);
+	AABBTree Tree;
+	std::vector<int32_t> Proxies;
+	for (uint32_t i = 0; i < Bounds.size(); ++i)
+	{
+		Proxies.push_back(Tree.CreateProxy(Bounds[i], i));
+	}
+
+	const uint32_t HardwareThreads = std::thread::hardware_concurrency();
+	std::printf("\nParallel tree queries, %u colliders (hardware threads: %u)\n", ColliderCount, HardwareThreads);
+	if (HardwareThreads < 8)
+	{
+		std::printf("Rows above %u threads share cores, so their speedup does not measure scaling.\n", HardwareThreads);
+	}
+	std::printf("%10s %10s %16s %10s\n", "threads", "pairs", "ms", "speedup");
+
+	std::vector<PairList> WorkerPairs;
+	PairList Pairs;
+	double SingleThreadMilliseconds = 0.0;
+	for (const uint32_t ThreadCount : { 1u, 2u, 4u, 8u })
+	{
+		const double Milliseconds = MeasureMilliseconds(20, [&]()
+		{
+			FindPairsParallel(Tree, Proxies, ThreadCount, WorkerPairs, Pairs);
+		});
+
+		if (ThreadCount == 1)
+		{
+			SingleThreadMilliseconds = Milliseconds;
+		}
+		std::printf("%10u %10zu %16.3f %9.1fx\n", ThreadCount, Pairs.size(), Milliseconds, SingleThreadMilliseconds / Milliseconds);
+	}
+}
+
+int main()
+{
+	std::printf("%10s %10s %16s %16s %10s\n", "colliders", "pairs", "nested loop ms", "spatial hash ms", "speedup");
+
+	for (const uint32_t ColliderCount : { 1000u, 10000u, 50000u })
+	{
+		const std::vector<AABB> Bounds = MakeScene(ColliderCount);
+		PairList NestedPairs;
+		PairList GridPairs;
+		SpatialHashGrid Grid(SpatialHashGrid::DefaultCellSize);
+
+		const uint32_t NestedIterations = ColliderCount <= 1000 ? 20 : 1;
+		const double NestedMilliseconds = MeasureMilliseconds(NestedIterations, [&]()
+		{
+			NestedPairs.clear();
+			FindPairsNestedLoop(Bounds, NestedPairs);
+		});
+
+		const double GridMilliseconds = MeasureMilliseconds(20, [&]()
+		{
+			GridPairs.clear();
+			Grid.Build(Bounds);
+			Grid.FindPairs(Bounds, GridPairs);
+		});
+
+		if (NestedPairs.size() != GridPairs.size())
+		{
+			std::printf("Pair count mismatch at %u colliders: nested loop %zu, spatial hash %zu\n", ColliderCount, NestedPairs.size(), GridPairs.size());
+			return 1;
+		}
+
+		std::printf("%10u %10zu %16.3f %16.3f %9.1fx\n", ColliderCount, GridPairs.size(), NestedMilliseconds, GridMilliseconds, NestedMilliseconds / GridMilliseconds);
+	}
+
+	RunThreadScaling(20000);
+	return 0;
+}
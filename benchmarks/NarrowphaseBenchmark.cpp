@@ -0,0 +1,160 @@
+#include "../src/Collision/AABB.hpp"
+#include "../src/Collision/AABBBatch.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Same distribution as the collision benchmark, but packed into a small world so that a
+// good share of the batch tests actually hit.
+static std::vector<AABB> MakeBoxes(uint32_t BoxCount, float WorldSize, uint32_t Seed)
+{
+	std::mt19937 Generator(Seed);
+	std::uniform_real_distribution<float> Position(0.0f, WorldSize);
+	std::uniform_real_distribution<float> Size(4.0f, 32.0f);
+
+	std::vector<AABB> Bounds;
+	Bounds.reserve(BoxCount);
+	for (uint32_t i = 0; i < BoxCount; ++i)
+	{
+		const float X = Position(Generator);
+		const float Y = Position(Generator);
+		Bounds.emplace_back(X, Y, X + Size(Generator), Y + Size(Generator));
+	}
+	return Bounds;
+}
+
+template <typename Function>
+static double MeasureMilliseconds(uint32_t Iterations, Function&& Body)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < Iterations; ++i)
+	{
+		Body();
+	}
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	return Elapsed.count() / Iterations;
+}
+
+// Tests every query against every box in MaxBatchSize chunks and folds the masks into a checksum.
+template <typename Kernel>
+static uint64_t RunBatches(const std::vector<AABB>& Queries, const AABBBatch& Boxes, Kernel&& TestBatch)
+{
+	uint64_t HitCount = 0;
+	for (const AABB& Query : Queries)
+	{
+		for (size_t Begin = 0; Begin < Boxes.Size(); Begin += MaxBatchSize)
+		{
+			const size_t Count = (std::min)(Boxes.Size() - Begin, MaxBatchSize);
+			HitCount += static_cast<uint64_t>(std::popcount(TestBatch(Query, Boxes, Begin, Count)));
+		}
+	}
+	return HitCount;
+}
+
+// Every batch length from 1 to MaxBatchSize, plus touching edges and NaN coordinates, must
+// produce bit-identical masks on both paths.
+static bool VerifyIdenticalMasks(const std::vector<AABB>& Queries, const std::vector<AABB>& Bounds)
+{
+	AABBBatch Boxes;
+	for (const AABB& Box : Bounds)
+	{
+		Boxes.Push(Box);
+	}
+
+	const float NaN = std::numeric_limits<float>::quiet_NaN();
+	Boxes.Push(AABB(0.0f, 0.0f, 16.0f, 16.0f));
+	Boxes.Push(AABB(16.0f, 0.0f, 32.0f, 16.0f));
+	Boxes.Push(AABB(NaN, 0.0f, 16.0f, 16.0f));
+	Boxes.Push(AABB(-1.0f, -1.0f, 1.0f, 1.0f));
+
+	std::vector<AABB> EdgeQueries = Queries;
+	EdgeQueries.emplace_back(0.0f, 0.0f, 16.0f, 16.0f);
+	EdgeQueries.emplace_back(NaN, NaN, NaN, NaN);
+
+	for (const AABB& Query : EdgeQueries)
+	{
+		for (size_t Count = 1; Count <= MaxBatchSize; ++Count)
+		{
+			for (size_t Begin = 0; Begin + Count <= Boxes.Size(); Begin += 61)
+			{
+				if (OverlapMask(Query, Boxes, Begin, Count) != OverlapMaskScalar(Query, Boxes, Begin, Count))
+				{
+					std::printf("Mask mismatch at begin %zu, count %zu\n", Begin, Count);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	std::printf("Batch kernel: %s\n", GetOverlapKernelName());
+
+	if (!VerifyIdenticalMasks(MakeBoxes(64, 256.0f, 7), MakeBoxes(1024, 256.0f, 8)))
+	{
+		return 1;
+	}
+
+	std::printf("%10s %10s %10s %12s %12s %12s %10s\n", "queries", "boxes", "hits", "per-pair ms", "scalar ms", "simd ms", "speedup");
+
+	for (const uint32_t BoxCount : { 64u, 1024u, 16384u })
+	{
+		const std::vector<AABB> Bounds = MakeBoxes(BoxCount, 512.0f, 1234);
+		const std::vector<AABB> Queries = MakeBoxes(1024, 512.0f, 4321);
+		AABBBatch Boxes;
+		Boxes.Reserve(Bounds.size());
+		for (const AABB& Box : Bounds)
+		{
+			Boxes.Push(Box);
+		}
+
+		const uint32_t Iterations = BoxCount <= 1024 ? 50 : 5;
+
+		// The array-of-structs loop the narrowphase used before the batch kernel.
+		uint64_t PerPairHits = 0;
+		const double PerPairMilliseconds = MeasureMilliseconds(Iterations, [&]()
+		{
+			PerPairHits = 0;
+			for (const AABB& Query : Queries)
+			{
+				for (const AABB& Box : Bounds)
+				{
+					PerPairHits += Query.Overlaps(Box) ? 1 : 0;
+				}
+			}
+		});
+
+		uint64_t ScalarHits = 0;
+		const double ScalarMilliseconds = MeasureMilliseconds(Iterations, [&]()
+		{
+			ScalarHits = RunBatches(Queries, Boxes, OverlapMaskScalar);
+		});
+
+		uint64_t SimdHits = 0;
+		const double SimdMilliseconds = MeasureMilliseconds(Iterations, [&]()
+		{
+			SimdHits = RunBatches(Queries, Boxes, OverlapMask);
+		});
+
+		if (PerPairHits != ScalarHits || ScalarHits != SimdHits)
+		{
+			std::printf("Hit count mismatch at %u boxes: per-pair %llu, scalar %llu, simd %llu\n", BoxCount,
+				static_cast<unsigned long long>(PerPairHits), static_cast<unsigned long long>(ScalarHits), static_cast<unsigned long long>(SimdHits));
+			return 1;
+		}
+
+		std::printf("%10zu %10u %10llu %12.3f %12.3f %12.3f %9.1fx\n", Queries.size(), BoxCount, static_cast<unsigned long long>(SimdHits),
+			PerPairMilliseconds, ScalarMilliseconds, SimdMilliseconds, ScalarMilliseconds / SimdMilliseconds);
+	}
+
+	return 0;
+}
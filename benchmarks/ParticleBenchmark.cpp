@@ -0,0 +1,110 @@
+#include "../src/Particles/ParticlePool.hpp"
+#include "../src/Particles/ParticleSystem.hpp"
+
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr uint32_t LiveParticles = 100000;
+constexpr float TickSeconds = 1.0f / 60.0f;
+constexpr SDL_FRect Camera = { 0.0f, 0.0f, 1920.0f, 1080.0f };
+
+// The array-of-structs layout a particle entity or a naive particle struct would have.
+struct ReferenceParticle
+{
+	glm::vec2 Position;
+	glm::vec2 Velocity;
+	float Life;
+	float InverseLifetime;
+	float Size;
+	SDL_FColor Color;
+};
+
+template <typename Function>
+static double MeasureMilliseconds(uint32_t Iterations, Function&& Body)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < Iterations; ++i)
+	{
+		Body();
+	}
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	return Elapsed.count() / Iterations;
+}
+
+int main()
+{
+	std::mt19937 Generator(1234);
+	std::uniform_real_distribution<float> PositionX(0.0f, Camera.w);
+	std::uniform_real_distribution<float> PositionY(0.0f, Camera.h);
+	std::uniform_real_distribution<float> Velocity(-50.0f, 50.0f);
+
+	// Lifetimes long enough that nobody dies while measuring, so both layouts do the same work.
+	ParticlePool Pool(LiveParticles);
+	std::vector<ReferenceParticle> Reference;
+	Reference.reserve(LiveParticles);
+	for (uint32_t i = 0; i < LiveParticles; ++i)
+	{
+		const glm::vec2 Position(PositionX(Generator), PositionY(Generator));
+		const glm::vec2 Speed(Velocity(Generator), Velocity(Generator));
+		Pool.Emit(Position, Speed, 1000.0f, 4.0f, { 1.0f, 0.5f, 0.2f, 1.0f });
+		Reference.push_back({ Position, Speed, 1000.0f, 1.0f / 1000.0f, 4.0f, { 1.0f, 0.5f, 0.2f, 1.0f } });
+	}
+
+	const uint32_t Iterations = 200;
+	const double ReferenceMilliseconds = MeasureMilliseconds(Iterations, [&Reference]()
+	{
+		for (ReferenceParticle& Particle : Reference)
+		{
+			Particle.Position += Particle.Velocity * TickSeconds;
+			Particle.Life -= TickSeconds;
+		}
+	});
+	const double PoolMilliseconds = MeasureMilliseconds(Iterations, [&Pool]()
+	{
+		Pool.Update(TickSeconds);
+	});
+
+	std::vector<SDL_Vertex> Vertices;
+	Vertices.reserve(LiveParticles * 4);
+	size_t QuadCount = 0;
+	const double VertexMilliseconds = MeasureMilliseconds(50, [&Pool, &Vertices, &QuadCount]()
+	{
+		Vertices.clear();
+		QuadCount = Pool.AppendVertices(Camera, { 0.0f, 0.0f, 1.0f, 1.0f }, Vertices);
+	});
+
+	if (Pool.GetCount() != LiveParticles)
+	{
+		std::printf("Particles died early: %u of %u left\n", Pool.GetCount(), LiveParticles);
+		return 1;
+	}
+
+	// Steady state with churn: short lifetimes, topped back up to LiveParticles every tick.
+	ParticleSystem Particles;
+	Particles.SetPoolCapacity(LiveParticles);
+	ParticleEffect Effect;
+	Effect.Texture.Index = 1;
+	Effect.Lifetime = 1.0f;
+	Effect.LifetimeVariance = 1.0f;
+	Effect.Speed = 60.0f;
+	Effect.SpeedVariance = 40.0f;
+	Particles.Emit(Effect, glm::vec2(Camera.w / 2.0f, Camera.h / 2.0f), LiveParticles);
+	const double ChurnMilliseconds = MeasureMilliseconds(Iterations, [&Particles, &Effect]()
+	{
+		Particles.Update(TickSeconds);
+		Particles.Emit(Effect, glm::vec2(Camera.w / 2.0f, Camera.h / 2.0f), LiveParticles - Particles.GetParticleCount());
+	});
+
+	std::printf("%u live particles, %u ticks\n", LiveParticles, Iterations);
+	std::printf("%-28s %10.3f ms\n", "update, array of structs", ReferenceMilliseconds);
+	std::printf("%-28s %10.3f ms (%.1fx)\n", "update, pool", PoolMilliseconds, ReferenceMilliseconds / PoolMilliseconds);
+	std::printf("%-28s %10.3f ms (%zu quads)\n", "vertices", VertexMilliseconds, QuadCount);
+	std::printf("%-28s %10.3f ms\n", "update + emit with churn", ChurnMilliseconds);
+	return 0;
+}
@@ -0,0 +1,144 @@
+#include "../src/Render/SpriteBatch.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+struct BenchmarkSprite
+{
+	SDL_Texture* Texture;
+	int ZIndex;
+	SDL_FRect SourceRectangle;
+	SDL_FRect DestinationRectangle;
+	double Rotation;
+	SDL_FlipMode Flip;
+};
+
+constexpr int ScreenWidth = 1920;
+constexpr int ScreenHeight = 1080;
+constexpr int TextureCount = 4;
+
+// 128x128 sheets of 32x32 frames, filled with a different colour each so the blits do real work.
+static std::vector<SDL_Texture*> MakeTextures(SDL_Renderer* Renderer)
+{
+	std::vector<SDL_Texture*> Textures;
+	for (int i = 0; i < TextureCount; ++i)
+	{
+		SDL_Surface* Surface = SDL_CreateSurface(128, 128, SDL_PIXELFORMAT_RGBA8888);
+		SDL_FillSurfaceRect(Surface, nullptr, SDL_MapSurfaceRGBA(Surface, static_cast<Uint8>(60 * i), 128, static_cast<Uint8>(255 - 60 * i), 255));
+		Textures.push_back(SDL_CreateTextureFromSurface(Renderer, Surface));
+		SDL_DestroySurface(Surface);
+	}
+	return Textures;
+}
+
+// Every sprite is on screen. A quarter of them are rotated and a quarter flipped, which roughly
+// matches the level scripts.
+static std::vector<BenchmarkSprite> MakeSprites(const std::vector<SDL_Texture*>& Textures, uint32_t SpriteCount)
+{
+	std::mt19937 Generator(1234);
+	std::uniform_real_distribution<float> PositionX(0.0f, ScreenWidth - 32.0f);
+	std::uniform_real_distribution<float> PositionY(0.0f, ScreenHeight - 32.0f);
+	std::uniform_int_distribution<int> Frame(0, 3);
+	std::uniform_int_distribution<int> Texture(0, TextureCount - 1);
+	std::uniform_int_distribution<int> ZIndex(0, 4);
+	std::uniform_int_distribution<int> Quarter(0, 3);
+
+	std::vector<BenchmarkSprite> Sprites;
+	Sprites.reserve(SpriteCount);
+	for (uint32_t i = 0; i < SpriteCount; ++i)
+	{
+		const int Variant = Quarter(Generator);
+		Sprites.push_back
+		({
+			Textures[Texture(Generator)],
+			ZIndex(Generator),
+			{ Frame(Generator) * 32.0f, Frame(Generator) * 32.0f, 32.0f, 32.0f },
+			{ std::round(PositionX(Generator)), std::round(PositionY(Generator)), 32.0f, 32.0f },
+			Variant == 0 ? 90.0 : 0.0,
+			Variant == 1 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE
+		});
+	}
+	return Sprites;
+}
+
+template <typename Function>
+static double MeasureMilliseconds(uint32_t Iterations, Function&& Body)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < Iterations; ++i)
+	{
+		Body();
+	}
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	return Elapsed.count() / Iterations;
+}
+
+int main()
+{
+	SDL_Surface* Target = SDL_CreateSurface(ScreenWidth, ScreenHeight, SDL_PIXELFORMAT_XRGB8888);
+	SDL_Renderer* Renderer = Target ? SDL_CreateSoftwareRenderer(Target) : nullptr;
+	if (!Renderer)
+	{
+		std::printf("Could not create the software renderer: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	const std::vector<SDL_Texture*> Textures = MakeTextures(Renderer);
+	std::printf("%10s %16s %16s %12s %10s\n", "sprites", "per-sprite ms", "batched ms", "draw calls", "speedup");
+
+	for (const uint32_t SpriteCount : { 1000u, 10000u })
+	{
+		std::vector<BenchmarkSprite> Sprites = MakeSprites(Textures, SpriteCount);
+		const uint32_t Iterations = SpriteCount <= 1000 ? 50 : 10;
+
+		// The previous path: sort by z-index, then one SDL_RenderTextureRotated call per sprite.
+		const double PerSpriteMilliseconds = MeasureMilliseconds(Iterations, [&]()
+		{
+			std::vector<BenchmarkSprite> Sorted = Sprites;
+			std::sort(Sorted.begin(), Sorted.end(), [](const BenchmarkSprite& A, const BenchmarkSprite& B)
+			{
+				return A.ZIndex < B.ZIndex;
+			});
+
+			SDL_RenderClear(Renderer);
+			for (const BenchmarkSprite& Sprite : Sorted)
+			{
+				SDL_RenderTextureRotated(Renderer, Sprite.Texture, &Sprite.SourceRectangle, &Sprite.DestinationRectangle, Sprite.Rotation, nullptr, Sprite.Flip);
+			}
+			SDL_FlushRenderer(Renderer);
+		});
+
+		SpriteBatch Batch;
+		RenderCommandList Commands;
+		const double BatchedMilliseconds = MeasureMilliseconds(Iterations, [&]()
+		{
+			SDL_RenderClear(Renderer);
+			Batch.Begin();
+			for (const BenchmarkSprite& Sprite : Sprites)
+			{
+				Batch.Add(Sprite.Texture, Sprite.ZIndex, Sprite.SourceRectangle, Sprite.DestinationRectangle, Sprite.Rotation, Sprite.Flip);
+			}
+			Commands.Reset();
+			Batch.Flush(Commands);
+			Commands.Execute(Renderer);
+			SDL_FlushRenderer(Renderer);
+		});
+
+		std::printf("%10u %16.3f %16.3f %12zu %9.1fx\n", SpriteCount, PerSpriteMilliseconds, BatchedMilliseconds, Batch.GetDrawCallCount(), PerSpriteMilliseconds / BatchedMilliseconds);
+	}
+
+	for (SDL_Texture* Texture : Textures)
+	{
+		SDL_DestroyTexture(Texture);
+	}
+	SDL_DestroyRenderer(Renderer);
+	SDL_DestroySurface(Target);
+	return 0;
+}
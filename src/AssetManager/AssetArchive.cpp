@@ -0,0 +1,180 @@
+#include "AssetArchive.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::string NormalizeArchivePath(std::string_view FilePath)
+{
+	return std::filesystem::path(FilePath).lexically_normal().generic_string();
+}
+
+AssetArchive::~AssetArchive()
+{
+	Close();
+}
+
+bool AssetArchive::Open(const std::string& FilePath)
+{
+	Close();
+	this->FilePath = FilePath;
+
+#ifdef _WIN32
+	HANDLE File = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		spdlog::error("Could not open asset archive {}", FilePath);
+		return false;
+	}
+	FileHandle = File;
+
+	LARGE_INTEGER FileSize;
+	HANDLE Mapping = GetFileSizeEx(File, &FileSize) && FileSize.QuadPart > 0 ? CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	MappingHandle = Mapping;
+	Bytes = Mapping ? static_cast<const uint8_t*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	Size = Bytes ? static_cast<size_t>(FileSize.QuadPart) : 0;
+#else
+	const int File = open(FilePath.c_str(), O_RDONLY);
+	if (File < 0)
+	{
+		spdlog::error("Could not open asset archive {}", FilePath);
+		return false;
+	}
+
+	// The mapping keeps its own reference to the file, so the descriptor is not needed afterwards.
+	struct stat FileStatus;
+	if (fstat(File, &FileStatus) == 0 && FileStatus.st_size > 0)
+	{
+		void* Mapping = mmap(nullptr, static_cast<size_t>(FileStatus.st_size), PROT_READ, MAP_PRIVATE, File, 0);
+		if (Mapping != MAP_FAILED)
+		{
+			Bytes = static_cast<const uint8_t*>(Mapping);
+			Size = static_cast<size_t>(FileStatus.st_size);
+		}
+	}
+	close(File);
+#endif
+
+	if (!Bytes)
+	{
+		spdlog::error("Could not map asset archive {}", FilePath);
+		Close();
+		return false;
+	}
+	if (!Validate())
+	{
+		spdlog::error("Asset archive {} is corrupt or from another version", FilePath);
+		Close();
+		return false;
+	}
+
+	spdlog::info("Asset archive {} mapped with {} entries ({} KB)", FilePath, Entries.size(), Size / 1024);
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	Entries.clear();
+#ifdef _WIN32
+	if (Bytes)
+	{
+		UnmapViewOfFile(Bytes);
+	}
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+	}
+	if (FileHandle)
+	{
+		CloseHandle(FileHandle);
+	}
+#else
+	if (Bytes)
+	{
+		munmap(const_cast<uint8_t*>(Bytes), Size);
+	}
+#endif
+	Bytes = nullptr;
+	Size = 0;
+	FileHandle = nullptr;
+	MappingHandle = nullptr;
+}
+
+size_t AssetArchive::DropStaleEntries()
+{
+	std::error_code Error;
+	const auto ArchiveTime = std::filesystem::last_write_time(FilePath, Error);
+	if (Error)
+	{
+		return 0;
+	}
+
+	size_t Dropped = 0;
+	for (auto Entry = Entries.begin(); Entry != Entries.end();)
+	{
+		const auto LooseTime = std::filesystem::last_write_time(std::filesystem::path(Entry->first), Error);
+		if (!Error && LooseTime > ArchiveTime)
+		{
+			spdlog::info("{} is newer than {}, loading the loose file", Entry->first, FilePath);
+			Entry = Entries.erase(Entry);
+			++Dropped;
+			continue;
+		}
+		++Entry;
+	}
+	return Dropped;
+}
+
+const AssetArchiveEntry* AssetArchive::Find(std::string_view FilePath) const
+{
+	const auto Entry = Entries.find(NormalizeArchivePath(FilePath));
+	return Entry != Entries.end() ? Entry->second : nullptr;
+}
+
+// Every offset is checked once here, so lookups can trust the table of contents afterwards.
+bool AssetArchive::Validate()
+{
+	if (Size < sizeof(AssetArchiveHeader))
+	{
+		return false;
+	}
+
+	AssetArchiveHeader Header;
+	std::memcpy(&Header, Bytes, sizeof(Header));
+	if (std::memcmp(Header.Magic, AssetArchiveMagic, sizeof(Header.Magic)) != 0 || Header.Version != AssetArchiveVersion)
+	{
+		return false;
+	}
+	if (Header.EntryCount > (Size - sizeof(Header)) / sizeof(AssetArchiveEntry))
+	{
+		return false;
+	}
+
+	const AssetArchiveEntry* Table = reinterpret_cast<const AssetArchiveEntry*>(Bytes + sizeof(Header));
+	for (uint32_t i = 0; i < Header.EntryCount; ++i)
+	{
+		const AssetArchiveEntry& Entry = Table[i];
+		const bool IsInBounds = Entry.PathOffset <= Size && Entry.PathLength <= Size - Entry.PathOffset
+			&& Entry.DataOffset <= Size && Entry.DataSize <= Size - Entry.DataOffset;
+		const bool IsValidTexture = Entry.Type != ArchiveEntryType::Texture
+			|| static_cast<uint64_t>(Entry.Width) * Entry.Height * 4 == Entry.DataSize;
+		if (!IsInBounds || !IsValidTexture)
+		{
+			return false;
+		}
+		Entries.emplace(std::string_view(reinterpret_cast<const char*>(Bytes + Entry.PathOffset), Entry.PathLength), &Entry);
+	}
+	return true;
+}
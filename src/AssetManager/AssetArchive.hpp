@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+inline constexpr char AssetArchiveMagic[8] = { 'R', 'L', 'P', 'A', 'K', '\0', '\0', '\0' };
+inline constexpr uint32_t AssetArchiveVersion = 1;
+// Entry data is aligned so texture rows can be read in place.
+inline constexpr uint64_t AssetArchiveAlignment = 16;
+
+enum class ArchiveEntryType : uint32_t
+{
+	Texture = 0,
+	Font = 1,
+	Script = 2,
+	// The WAV file as is; AudioMixer decodes or streams it from the mapping.
+	Sound = 3
+};
+
+// On-disk layout, little-endian: the header, the table of contents, the entry paths, then the
+// entry data. Offsets are from the start of the file.
+struct AssetArchiveHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t EntryCount;
+};
+
+struct AssetArchiveEntry
+{
+	ArchiveEntryType Type;
+	uint32_t PathLength;
+	uint64_t PathOffset;
+	uint64_t DataOffset;
+	uint64_t DataSize;
+	// HashFile of the source file, so atlas cache keys match the loose files without reading them.
+	uint64_t SourceHash;
+	// Textures only: RGBA32 pixels with tightly packed rows, ready to upload.
+	uint32_t Width;
+	uint32_t Height;
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 16, "AssetArchiveHeader must match the on-disk layout");
+static_assert(sizeof(AssetArchiveEntry) == 48, "AssetArchiveEntry must match the on-disk layout");
+
+// Entries are keyed by the path the level script uses, so "./assets/x.png" and "assets/x.png" match.
+std::string NormalizeArchivePath(std::string_view FilePath);
+
+// A read-only memory mapping of a packed archive. Nothing is copied on open: the table of contents
+// and the entry data are read straight from the mapping, which lives until Close.
+class AssetArchive
+{
+public:
+	AssetArchive() = default;
+	~AssetArchive();
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	bool Open(const std::string& FilePath);
+	void Close();
+	// Forgets the entries whose loose file was modified after the archive was written, so edited
+	// files are loaded from disk until the archive is rebuilt. Returns how many were dropped.
+	size_t DropStaleEntries();
+
+	const AssetArchiveEntry* Find(std::string_view FilePath) const;
+	const uint8_t* GetData(const AssetArchiveEntry& Entry) const { return Bytes + Entry.DataOffset; }
+	const std::string& GetFilePath() const { return FilePath; }
+	size_t GetEntryCount() const { return Entries.size(); }
+
+private:
+	bool Validate();
+
+	std::string FilePath;
+	const uint8_t* Bytes = nullptr;
+	size_t Size = 0;
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+	std::unordered_map<std::string_view, const AssetArchiveEntry*> Entries;
+};
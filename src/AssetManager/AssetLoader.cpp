@@ -0,0 +1,66 @@
+#include "AssetLoader.hpp"
+
+#include <algorithm>
+
+AssetLoader::AssetLoader(int ThreadCount)
+{
+	for (int i = 0; i < (std::max)(ThreadCount, 1); ++i)
+	{
+		Workers.emplace_back(&AssetLoader::RunWorker, this);
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> Lock(JobsMutex);
+		IsStopping = true;
+	}
+	JobQueued.notify_all();
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+}
+
+void AssetLoader::Enqueue(std::function<void()> Job)
+{
+	{
+		std::lock_guard<std::mutex> Lock(JobsMutex);
+		Jobs.push_back(std::move(Job));
+	}
+	JobQueued.notify_one();
+}
+
+void AssetLoader::Wait()
+{
+	std::unique_lock<std::mutex> Lock(JobsMutex);
+	JobsFinished.wait(Lock, [this]() { return Jobs.empty() && RunningJobs == 0; });
+}
+
+void AssetLoader::RunWorker()
+{
+	while (true)
+	{
+		std::function<void()> Job;
+		{
+			std::unique_lock<std::mutex> Lock(JobsMutex);
+			JobQueued.wait(Lock, [this]() { return IsStopping || !Jobs.empty(); });
+			if (Jobs.empty())
+			{
+				return;
+			}
+			Job = std::move(Jobs.front());
+			Jobs.pop_front();
+			++RunningJobs;
+		}
+
+		Job();
+
+		{
+			std::lock_guard<std::mutex> Lock(JobsMutex);
+			--RunningJobs;
+		}
+		JobsFinished.notify_all();
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small pool of worker threads for decoding assets off the main thread. Jobs must never touch the
+// renderer: the decoded surfaces are handed back and uploaded by the thread that owns it.
+class AssetLoader
+{
+public:
+	explicit AssetLoader(int ThreadCount);
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	void Enqueue(std::function<void()> Job);
+	// Completion barrier: returns once every job queued so far has finished.
+	void Wait();
+	size_t GetThreadCount() const { return Workers.size(); }
+
+private:
+	void RunWorker();
+
+	std::vector<std::thread> Workers;
+	std::deque<std::function<void()>> Jobs;
+	std::mutex JobsMutex;
+	std::condition_variable JobQueued;
+	std::condition_variable JobsFinished;
+	size_t RunningJobs = 0;
+	bool IsStopping = false;
+};
@@ -1,11 +1,59 @@
 #include "AssetManager.hpp"
+#include "TextureAtlas.hpp"
 
 #include <SDL3_image/SDL_image.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <filesystem>
+
+static const std::string AtlasCacheDirectory = "./cache/atlas";
+static constexpr int MaxAtlasPageSize = 2048;
+// Lazy textures are only evicted once they have gone this many frames without being drawn.
+static constexpr uint64_t MinEvictionAgeFrames = 600;
+static constexpr int StreamingThreads = 2;
+
+static std::string GetAtlasCachePath(uint64_t Key, const std::string& Suffix)
+{
+	return fmt::format("{}/{:016x}{}", AtlasCacheDirectory, Key, Suffix);
+}
+
+static double MillisecondsSince(uint64_t StartNS)
+{
+	return static_cast<double>(SDL_GetTicksNS() - StartNS) / 1e6;
+}
+
+static TextureRegion MakeRegion(SDL_Texture* Texture, const SDL_Rect& Rect)
+{
+	return TextureRegion{ Texture, { static_cast<float>(Rect.x), static_cast<float>(Rect.y), static_cast<float>(Rect.w), static_cast<float>(Rect.h) } };
+}
+
+// Copies the image into the page, then repeats its outermost rows and columns into the padding.
+static void BlitExtruded(SDL_Surface* Image, SDL_Surface* Page, const SDL_Rect& Rect)
+{
+	SDL_Rect Destination = Rect;
+	SDL_BlitSurface(Image, nullptr, Page, &Destination);
+
+	const SDL_Rect Edges[4][2] =
+	{
+		{ { 0, 0, Rect.w, 1 }, { Rect.x, Rect.y - 1, Rect.w, 1 } },
+		{ { 0, Rect.h - 1, Rect.w, 1 }, { Rect.x, Rect.y + Rect.h, Rect.w, 1 } },
+		{ { 0, 0, 1, Rect.h }, { Rect.x - 1, Rect.y, 1, Rect.h } },
+		{ { Rect.w - 1, 0, 1, Rect.h }, { Rect.x + Rect.w, Rect.y, 1, Rect.h } }
+	};
+	for (const auto& Edge : Edges)
+	{
+		SDL_Rect EdgeDestination = Edge[1];
+		SDL_BlitSurface(Image, &Edge[0], Page, &EdgeDestination);
+	}
+}
+
 
 AssetManager::AssetManager()
 {
+	TextureRegions.emplace_back();
+	TextureAssetIDs.emplace_back();
+	TextureSlots.emplace_back();
 	spdlog::info("AssetManager created");
 }
 
@@ -17,52 +65,981 @@ AssetManager::~AssetManager()
 
 void AssetManager::ClearAssets()
 {
+	WaitForStreaming();
+	for (const StreamedTexture& Streamed : StreamedTextures)
+	{
+		SDL_DestroySurface(Streamed.Image);
+	}
+	StreamedTextures.clear();
+
 	for (auto Texture : Textures)
 	{
 		SDL_DestroyTexture(Texture.second);
 	}
 	Textures.clear();
 
+	for (const AtlasPage& Page : AtlasPages)
+	{
+		if (Page.Texture)
+		{
+			SDL_DestroyTexture(Page.Texture);
+		}
+	}
+	AtlasPages.clear();
+	ResidentTextureBytes = 0;
+	std::fill(TextureRegions.begin(), TextureRegions.end(), TextureRegion());
+	for (TextureSlot& Slot : TextureSlots)
+	{
+		Slot = TextureSlot{ std::string(), 0, Slot.Generation + 1, false, false };
+	}
+
+	GlyphAtlases.clear();
+
 	for (auto Font : Fonts)
 	{
 		TTF_CloseFont(Font.second);
 	}
 	Fonts.clear();
+
+	for (const auto& [AssetID, Record] : Records)
+	{
+		SDL_free(Record.FontData);
+	}
+	Records.clear();
+	LevelAssetIDs.clear();
+	Archives.clear();
+}
+
+bool AssetManager::MountArchive(const std::string& FilePath)
+{
+	// Prefetches read the archive list from the streaming threads.
+	WaitForStreaming();
+	for (const std::unique_ptr<AssetArchive>& Archive : Archives)
+	{
+		if (Archive->GetFilePath() == FilePath)
+		{
+			return true;
+		}
+	}
+
+	auto Archive = std::make_unique<AssetArchive>();
+	if (!Archive->Open(FilePath))
+	{
+		return false;
+	}
+	Archive->DropStaleEntries();
+	Archives.push_back(std::move(Archive));
+	return true;
+}
+
+std::string_view AssetManager::GetPackedFile(const std::string& FilePath) const
+{
+	const uint8_t* Data = nullptr;
+	const AssetArchiveEntry* Entry = FindPackedEntry(FilePath, &Data);
+	return Entry ? std::string_view(reinterpret_cast<const char*>(Data), Entry->DataSize) : std::string_view();
+}
+
+const AssetArchiveEntry* AssetManager::FindPackedEntry(const std::string& FilePath, const uint8_t** OutData) const
+{
+	for (auto Archive = Archives.rbegin(); Archive != Archives.rend(); ++Archive)
+	{
+		if (const AssetArchiveEntry* Entry = (*Archive)->Find(FilePath))
+		{
+			*OutData = (*Archive)->GetData(*Entry);
+			return Entry;
+		}
+	}
+	return nullptr;
+}
+
+SDL_Surface* AssetManager::LoadTextureSurface(const std::string& FilePath) const
+{
+	const uint8_t* Data = nullptr;
+	const AssetArchiveEntry* Entry = FindPackedEntry(FilePath, &Data);
+	if (!Entry || Entry->Type != ArchiveEntryType::Texture)
+	{
+		SDL_Surface* Loaded = IMG_Load(FilePath.c_str());
+		SDL_Surface* Image = Loaded ? SDL_ConvertSurface(Loaded, SDL_PIXELFORMAT_RGBA32) : nullptr;
+		SDL_DestroySurface(Loaded);
+		return Image;
+	}
+
+	// The mapping is read-only, but SDL only reads the pixels of a surface that is blitted or uploaded.
+	return SDL_CreateSurfaceFrom(static_cast<int>(Entry->Width), static_cast<int>(Entry->Height), SDL_PIXELFORMAT_RGBA32, const_cast<uint8_t*>(Data), static_cast<int>(Entry->Width) * 4);
+}
+
+LevelAssetCounts AssetManager::LoadLevelAssets(SDL_Renderer* Renderer, const std::vector<std::pair<std::string, std::string>>& TextureFiles, const std::vector<FontFile>& FontFiles, AssetLoader& Loader)
+{
+	const std::set<std::string> PreviousLevel = std::move(LevelAssetIDs);
+	LevelAssetIDs.clear();
+
+	std::vector<std::pair<std::string, std::string>> NewTextures;
+	LevelAssetCounts Counts;
+	for (const auto& File : TextureFiles)
+	{
+		if (AddToLevel(File.first))
+		{
+			++Counts.Kept;
+		}
+		else
+		{
+			NewTextures.push_back(File);
+		}
+	}
+	for (const FontFile& File : FontFiles)
+	{
+		if (AddToLevel(File.AssetID))
+		{
+			++Counts.Kept;
+		}
+		else
+		{
+			QueueFont(File.AssetID, File.FilePath, File.FontSize, Loader);
+		}
+	}
+
+	// Released before the new textures are decoded, so both levels are never resident at once.
+	for (const std::string& AssetID : PreviousLevel)
+	{
+		Counts.Released += LevelAssetIDs.contains(AssetID) ? 0 : 1;
+		ReleaseAsset(AssetID);
+	}
+
+	if (LazyRenderer)
+	{
+		for (const auto& [AssetID, FilePath] : NewTextures)
+		{
+			RegisterTexture(AssetID, FilePath);
+		}
+	}
+	else
+	{
+		AddTextureAtlas(Renderer, NewTextures, Loader);
+	}
+	FinishLoading(Loader);
+
+	Counts.Loaded = LevelAssetIDs.size() - Counts.Kept;
+	spdlog::info("Level assets: {} kept resident, {} released, {} loaded", Counts.Kept, Counts.Released, Counts.Loaded);
+	return Counts;
+}
+
+bool AssetManager::AcquireAsset(const std::string& AssetID)
+{
+	const auto Record = Records.find(AssetID);
+	if (Record == Records.end())
+	{
+		return false;
+	}
+	++Record->second.RefCount;
+	return true;
+}
+
+void AssetManager::ReleaseAsset(const std::string& AssetID)
+{
+	const auto Record = Records.find(AssetID);
+	if (Record == Records.end() || Record->second.RefCount == 0)
+	{
+		spdlog::warn("Released asset {} which holds no references", AssetID);
+		return;
+	}
+
+	if (--Record->second.RefCount == 0)
+	{
+		UnloadAsset(AssetID, Record->second);
+		Records.erase(Record);
+	}
+}
+
+size_t AssetManager::GetAtlasPageBytes() const
+{
+	size_t Bytes = 0;
+	for (const AtlasPage& Page : AtlasPages)
+	{
+		Bytes += Page.Bytes;
+	}
+	return Bytes;
+}
+
+// Released pages keep their slot, so only the ones that still hold a texture are counted.
+size_t AssetManager::GetAtlasPageCount() const
+{
+	return static_cast<size_t>(std::count_if(AtlasPages.begin(), AtlasPages.end(), [](const AtlasPage& Page)
+	{
+		return Page.Texture != nullptr;
+	}));
+}
+
+bool AssetManager::AddToLevel(const std::string& AssetID)
+{
+	if (!Records.contains(AssetID))
+	{
+		return false;
+	}
+	if (LevelAssetIDs.insert(AssetID).second)
+	{
+		AcquireAsset(AssetID);
+	}
+	return true;
+}
+
+void AssetManager::UnloadAsset(const std::string& AssetID, const AssetRecord& Record)
+{
+	if (Record.Type == AssetType::Texture)
+	{
+		const uint32_t Index = InternTexture(AssetID);
+		TextureRegions[Index] = TextureRegion();
+		TextureSlots[Index] = TextureSlot{ std::string(), 0, TextureSlots[Index].Generation + 1, false, false };
+		if (Record.AtlasPage < 0)
+		{
+			const auto Texture = Textures.find(AssetID);
+			if (Texture != Textures.end())
+			{
+				SDL_DestroyTexture(Texture->second);
+				Textures.erase(Texture);
+				ResidentTextureBytes -= Record.ResidentBytes;
+			}
+		}
+		else if (--AtlasPages[Record.AtlasPage].RegionCount == 0)
+		{
+			AtlasPage& Page = AtlasPages[Record.AtlasPage];
+			SDL_DestroyTexture(Page.Texture);
+			ResidentTextureBytes -= Page.Bytes;
+			spdlog::info("Atlas page {} released, {} KB freed", Record.AtlasPage, Page.Bytes / 1024);
+			Page = AtlasPage();
+		}
+	}
+	else
+	{
+		const auto Font = Fonts.find(AssetID);
+		if (Font != Fonts.end())
+		{
+			TTF_CloseFont(Font->second);
+			Fonts.erase(Font);
+		}
+		SDL_free(Record.FontData);
+		std::erase_if(GlyphAtlases, [&AssetID](const auto& Entry)
+		{
+			return Entry.first.first == AssetID;
+		});
+	}
+
+	spdlog::info("Asset {} unloaded, {} KB freed", AssetID, Record.ResidentBytes / 1024);
 }
 
 void AssetManager::AddTexture(SDL_Renderer* Renderer, const std::string &AssetID, const std::string &FilePath)
 {
-	SDL_Surface* Surface = IMG_Load(FilePath.c_str());
-	SDL_Texture* Texture = SDL_CreateTextureFromSurface(Renderer, Surface);
+	if (AddToLevel(AssetID))
+	{
+		return;
+	}
+
+	SDL_Surface* Surface = LoadTextureSurface(FilePath);
+	AddTextureFromSurface(Renderer, AssetID, Surface);
 	SDL_DestroySurface(Surface);
+}
+
+void AssetManager::AddTextureFromSurface(SDL_Renderer* Renderer, const std::string& AssetID, SDL_Surface* Surface)
+{
+	SDL_Texture* Texture = SDL_CreateTextureFromSurface(Renderer, Surface);
 
 	// Add texture to the map
 	Textures.emplace(AssetID, Texture);
 
+	float Width = 0.0f;
+	float Height = 0.0f;
+	SDL_GetTextureSize(Texture, &Width, &Height);
+	TextureRegions[InternTexture(AssetID)] = TextureRegion{ Texture, { 0.0f, 0.0f, Width, Height } };
+	Records[AssetID] = AssetRecord{ AssetType::Texture, 0, static_cast<size_t>(Width * Height) * 4, -1, nullptr };
+	ResidentTextureBytes += Records[AssetID].ResidentBytes;
+	AddToLevel(AssetID);
+
 	spdlog::info("Texture with AssetID: {} added", AssetID);
 }
 
-SDL_Texture *AssetManager::GetTexture(const std::string &AssetID) const
+size_t AssetManager::AddAtlasPage(SDL_Texture* Texture)
+{
+	float Width = 0.0f;
+	float Height = 0.0f;
+	SDL_GetTextureSize(Texture, &Width, &Height);
+	AtlasPages.push_back(AtlasPage{ Texture, 0, static_cast<size_t>(Width * Height) * 4, nullptr });
+	ResidentTextureBytes += AtlasPages.back().Bytes;
+	return AtlasPages.size() - 1;
+}
+
+void AssetManager::AddAtlasRegion(const std::string& AssetID, size_t Page, const SDL_Rect& Rect)
+{
+	TextureRegions[InternTexture(AssetID)] = MakeRegion(AtlasPages[Page].Texture, Rect);
+	++AtlasPages[Page].RegionCount;
+	Records[AssetID] = AssetRecord{ AssetType::Texture, 0, static_cast<size_t>(Rect.w) * Rect.h * 4, static_cast<int>(Page), nullptr };
+	AddToLevel(AssetID);
+}
+
+void AssetManager::AddTextureAtlas(SDL_Renderer* Renderer, const std::vector<std::pair<std::string, std::string>>& RequestedFiles, AssetLoader& Loader)
 {
-	if (Textures.find(AssetID) != Textures.end())
+	std::vector<std::pair<std::string, std::string>> Files;
+	std::set<std::string> Requested;
+	for (const auto& File : RequestedFiles)
 	{
-		return Textures.at(AssetID);
+		if (Requested.insert(File.first).second && !AddToLevel(File.first))
+		{
+			Files.push_back(File);
+		}
 	}
-	else
+	if (Files.empty())
+	{
+		return;
+	}
+
+	const SDL_PropertiesID RendererProperties = SDL_GetRendererProperties(Renderer);
+	const int PageSize = static_cast<int>((std::min)(static_cast<Sint64>(MaxAtlasPageSize), SDL_GetNumberProperty(RendererProperties, SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, MaxAtlasPageSize)));
+
+	// Hashing reads every loose file in full, so it is spread over the workers as well. Packed files
+	// carry the hash of their source, which keeps the cache key the same either way.
+	std::vector<uint64_t> FileHashes(Files.size());
+	for (size_t i = 0; i < Files.size(); ++i)
+	{
+		const uint8_t* Data = nullptr;
+		if (const AssetArchiveEntry* Entry = FindPackedEntry(Files[i].second, &Data))
+		{
+			FileHashes[i] = Entry->SourceHash;
+			continue;
+		}
+		Loader.Enqueue([&Files, &FileHashes, i]()
+		{
+			FileHashes[i] = HashFile(Files[i].second, 0);
+		});
+	}
+	Loader.Wait();
+
+	uint64_t Key = HashBytes(&PageSize, sizeof(PageSize), 0);
+	for (size_t i = 0; i < Files.size(); ++i)
+	{
+		Key = HashBytes(Files[i].first.data(), Files[i].first.size(), Key);
+		Key = HashBytes(&FileHashes[i], sizeof(FileHashes[i]), Key);
+	}
+
+	if (LoadCachedAtlas(Renderer, Key, Files, Loader))
+	{
+		spdlog::info("Texture atlas {:016x} with {} textures loaded from cache", Key, Files.size());
+		return;
+	}
+
+	std::vector<SDL_Surface*> Decoded(Files.size(), nullptr);
+	std::vector<double> DecodeMilliseconds(Files.size(), 0.0);
+	for (size_t i = 0; i < Files.size(); ++i)
+	{
+		Loader.Enqueue([this, &Files, &Decoded, &DecodeMilliseconds, i]()
+		{
+			const uint64_t StartNS = SDL_GetTicksNS();
+			SDL_Surface* Image = LoadTextureSurface(Files[i].second);
+			if (Image)
+			{
+				// Raw copies: blending onto the transparent page would darken semi-transparent pixels.
+				SDL_SetSurfaceBlendMode(Image, SDL_BLENDMODE_NONE);
+			}
+			Decoded[i] = Image;
+			DecodeMilliseconds[i] = MillisecondsSince(StartNS);
+		});
+	}
+	Loader.Wait();
+
+	std::vector<std::string> AssetIDs;
+	std::vector<std::string> FilePaths;
+	std::vector<SDL_Point> Sizes;
+	std::vector<SDL_Surface*> Images;
+	for (size_t i = 0; i < Files.size(); ++i)
+	{
+		const auto& [AssetID, FilePath] = Files[i];
+		SDL_Surface* Image = Decoded[i];
+		if (!Image)
+		{
+			spdlog::error("Could not load texture {} for the atlas", FilePath);
+			continue;
+		}
+
+		spdlog::info("Texture {} decoded in {:.2f} ms", AssetID, DecodeMilliseconds[i]);
+		AssetIDs.push_back(AssetID);
+		FilePaths.push_back(FilePath);
+		Sizes.push_back({ Image->w, Image->h });
+		Images.push_back(Image);
+	}
+
+	AtlasLayout Layout = PackAtlas(AssetIDs, Sizes, PageSize, PageSize);
+	Layout.Key = Key;
+
+	std::vector<SDL_Surface*> Pages;
+	for (int Page = 0; Page < Layout.PageCount; ++Page)
+	{
+		Pages.push_back(SDL_CreateSurface(PageSize, PageSize, SDL_PIXELFORMAT_RGBA32));
+		SDL_FillSurfaceRect(Pages.back(), nullptr, 0);
+	}
+
+	for (size_t i = 0; i < Images.size(); ++i)
+	{
+		const AtlasPlacement& Placement = Layout.Placements[i];
+		if (Placement.Page < 0)
+		{
+			spdlog::warn("Texture {} does not fit in a {}x{} atlas page", FilePaths[i], PageSize, PageSize);
+			AddTextureFromSurface(Renderer, AssetIDs[i], Images[i]);
+		}
+		else
+		{
+			BlitExtruded(Images[i], Pages[Placement.Page], Placement.Rect);
+		}
+		SDL_DestroySurface(Images[i]);
+	}
+
+	// The pages are written to the cache on the workers while they are uploaded here; both only read them.
+	std::error_code Error;
+	std::filesystem::create_directories(AtlasCacheDirectory, Error);
+	std::vector<uint8_t> IsPageSaved(Pages.size(), 0);
+	for (size_t Page = 0; !Error && Page < Pages.size(); ++Page)
+	{
+		Loader.Enqueue([&Pages, &IsPageSaved, Key, Page]()
+		{
+			IsPageSaved[Page] = SDL_SaveBMP(Pages[Page], GetAtlasCachePath(Key, "_" + std::to_string(Page) + ".bmp").c_str()) ? 1 : 0;
+		});
+	}
+	const size_t FirstPage = AtlasPages.size();
+	for (size_t Page = 0; Page < Pages.size(); ++Page)
+	{
+		const uint64_t StartNS = SDL_GetTicksNS();
+		AddAtlasPage(SDL_CreateTextureFromSurface(Renderer, Pages[Page]));
+		spdlog::info("Atlas page {} uploaded in {:.2f} ms", Page, MillisecondsSince(StartNS));
+	}
+	Loader.Wait();
+
+	const bool IsCached = !Error && std::all_of(IsPageSaved.begin(), IsPageSaved.end(), [](uint8_t IsSaved) { return IsSaved != 0; });
+	for (SDL_Surface* Page : Pages)
+	{
+		SDL_DestroySurface(Page);
+	}
+
+	// The layout is written last, so an interrupted write never leaves a layout without its pages.
+	if (!IsCached || !SaveAtlasLayout(GetAtlasCachePath(Key, ".txt"), Layout))
+	{
+		spdlog::warn("Could not write texture atlas cache to {}", AtlasCacheDirectory);
+	}
+
+	for (const AtlasPlacement& Placement : Layout.Placements)
+	{
+		if (Placement.Page >= 0)
+		{
+			AddAtlasRegion(Placement.AssetID, FirstPage + Placement.Page, Placement.Rect);
+		}
+	}
+
+	spdlog::info("Packed {} textures into {} atlas pages of {}x{}", AssetIDs.size(), Layout.PageCount, PageSize, PageSize);
+}
+
+bool AssetManager::LoadCachedAtlas(SDL_Renderer* Renderer, uint64_t Key, const std::vector<std::pair<std::string, std::string>>& Files, AssetLoader& Loader)
+{
+	AtlasLayout Layout;
+	if (!LoadAtlasLayout(GetAtlasCachePath(Key, ".txt"), Key, Layout))
+	{
+		return false;
+	}
+
+	std::vector<SDL_Surface*> Pages(Layout.PageCount, nullptr);
+	std::vector<double> DecodeMilliseconds(Pages.size(), 0.0);
+	for (size_t Page = 0; Page < Pages.size(); ++Page)
+	{
+		Loader.Enqueue([&Pages, &DecodeMilliseconds, Key, Page]()
+		{
+			const uint64_t StartNS = SDL_GetTicksNS();
+			Pages[Page] = SDL_LoadBMP(GetAtlasCachePath(Key, "_" + std::to_string(Page) + ".bmp").c_str());
+			DecodeMilliseconds[Page] = MillisecondsSince(StartNS);
+		});
+	}
+	Loader.Wait();
+
+	if (std::find(Pages.begin(), Pages.end(), nullptr) != Pages.end())
+	{
+		for (SDL_Surface* Loaded : Pages)
+		{
+			SDL_DestroySurface(Loaded);
+		}
+		return false;
+	}
+
+	const size_t FirstPage = AtlasPages.size();
+	for (size_t Page = 0; Page < Pages.size(); ++Page)
+	{
+		const uint64_t StartNS = SDL_GetTicksNS();
+		AddAtlasPage(SDL_CreateTextureFromSurface(Renderer, Pages[Page]));
+		spdlog::info("Atlas page {} decoded in {:.2f} ms, uploaded in {:.2f} ms", Page, DecodeMilliseconds[Page], MillisecondsSince(StartNS));
+		SDL_DestroySurface(Pages[Page]);
+	}
+
+	for (const AtlasPlacement& Placement : Layout.Placements)
+	{
+		if (Placement.Page >= 0)
+		{
+			AddAtlasRegion(Placement.AssetID, FirstPage + Placement.Page, Placement.Rect);
+			continue;
+		}
+
+		const auto File = std::find_if(Files.begin(), Files.end(), [&Placement](const auto& Entry)
+		{
+			return Entry.first == Placement.AssetID;
+		});
+		if (File != Files.end())
+		{
+			AddTexture(Renderer, File->first, File->second);
+		}
+	}
+	return true;
+}
+
+SDL_Texture *AssetManager::GetTexture(const std::string &AssetID)
+{
+	return GetTextureRegion(AssetID).Texture;
+}
+
+const TextureRegion& AssetManager::GetTextureRegion(const std::string& AssetID)
+{
+	const auto Handle = TextureHandles.find(AssetID);
+	if (Handle != TextureHandles.end())
+	{
+		const TextureRegion& Region = GetTextureRegion(TextureHandle{ Handle->second });
+		if (Region.Texture)
+		{
+			return Region;
+		}
+	}
+
+	spdlog::error("Texture with AssetID: {} not found", AssetID);
+	return TextureRegions[0];
+}
+
+TextureHandle AssetManager::GetTextureHandle(const std::string& AssetID)
+{
+	const TextureHandle Handle = { InternTexture(AssetID) };
+	if (!TextureRegions[Handle.Index].Texture && !TextureSlots[Handle.Index].IsLoadable)
 	{
 		spdlog::error("Texture with AssetID: {} not found", AssetID);
-		return nullptr;
+	}
+	return Handle;
+}
+
+const std::string& AssetManager::GetTextureAssetID(TextureHandle Handle) const
+{
+	return TextureAssetIDs[Handle.Index < TextureAssetIDs.size() ? Handle.Index : 0];
+}
+
+uint32_t AssetManager::InternTexture(const std::string& AssetID)
+{
+	const auto [Handle, IsNew] = TextureHandles.try_emplace(AssetID, static_cast<uint32_t>(TextureRegions.size()));
+	if (IsNew)
+	{
+		TextureRegions.emplace_back();
+		TextureAssetIDs.push_back(AssetID);
+		TextureSlots.emplace_back();
+	}
+	return Handle->second;
+}
+
+void AssetManager::EnableLazyTextures(SDL_Renderer* Renderer, size_t BudgetBytes, float PrefetchRadius)
+{
+	LazyRenderer = Renderer;
+	TextureBudgetBytes = BudgetBytes;
+	this->PrefetchRadius = PrefetchRadius;
+	if (!Streaming)
+	{
+		Streaming = std::make_unique<AssetLoader>(StreamingThreads);
+	}
+	spdlog::info("Lazy textures enabled with a {} MB budget and a {:.0f} px prefetch radius", BudgetBytes / (1024 * 1024), PrefetchRadius);
+}
+
+void AssetManager::RegisterTexture(const std::string& AssetID, const std::string& FilePath)
+{
+	const uint32_t Index = InternTexture(AssetID);
+	TextureSlot& Slot = TextureSlots[Index];
+	Slot.FilePath = FilePath;
+	Slot.IsLoadable = true;
+	Slot.IsPending = false;
+	Records[AssetID] = AssetRecord{ AssetType::Texture, 0, 0, -1, nullptr };
+	AddToLevel(AssetID);
+}
+
+void AssetManager::PrefetchTexture(TextureHandle Handle)
+{
+	const uint32_t Index = Handle.Index < TextureSlots.size() ? Handle.Index : 0;
+	TextureSlot& Slot = TextureSlots[Index];
+	Slot.LastUsedFrame = ResidencyFrame;
+	if (TextureRegions[Index].Texture || !Slot.IsLoadable || Slot.IsPending || !Streaming)
+	{
+		return;
+	}
+
+	Slot.IsPending = true;
+	Streaming->Enqueue([this, Index, FilePath = Slot.FilePath, Generation = Slot.Generation]()
+	{
+		SDL_Surface* Image = LoadTextureSurface(FilePath);
+		std::lock_guard<std::mutex> Lock(StreamingMutex);
+		StreamedTextures.push_back(StreamedTexture{ Index, Generation, Image });
+	});
+}
+
+void AssetManager::UpdateTextureResidency()
+{
+	if (!LazyRenderer)
+	{
+		return;
+	}
+	++ResidencyFrame;
+
+	std::vector<StreamedTexture> Finished;
+	{
+		std::lock_guard<std::mutex> Lock(StreamingMutex);
+		Finished.swap(StreamedTextures);
+	}
+	for (const StreamedTexture& Streamed : Finished)
+	{
+		TextureSlot& Slot = TextureSlots[Streamed.Index];
+		if (Slot.Generation == Streamed.Generation)
+		{
+			Slot.IsPending = false;
+			if (!Streamed.Image)
+			{
+				spdlog::error("Could not load texture {}", Slot.FilePath);
+				Slot.IsLoadable = false;
+			}
+			else if (!TextureRegions[Streamed.Index].Texture && Slot.IsLoadable)
+			{
+				UploadLazyTexture(Streamed.Index, Streamed.Image);
+			}
+		}
+		SDL_DestroySurface(Streamed.Image);
+	}
+
+	EvictUnusedTextures();
+}
+
+size_t AssetManager::GetResidentTextureBytes() const
+{
+	return ResidentTextureBytes;
+}
+
+// The synchronous path, for a texture that is needed this frame and was not prefetched in time.
+void AssetManager::MakeResident(uint32_t Index)
+{
+	TextureSlot& Slot = TextureSlots[Index];
+	SDL_Surface* Image = LazyRenderer ? LoadTextureSurface(Slot.FilePath) : nullptr;
+	if (!Image)
+	{
+		spdlog::error("Could not load texture {}", Slot.FilePath);
+		Slot.IsLoadable = false;
+		return;
+	}
+
+	UploadLazyTexture(Index, Image);
+	SDL_DestroySurface(Image);
+}
+
+// Adds the texture to the first lazy page with room, so lazily loaded sprites still batch together.
+// Space freed on a page is only reused once the whole page has been evicted or released. If the
+// texture cannot be created it stays non-resident and, like a file that fails to decode, is not retried.
+void AssetManager::UploadLazyTexture(uint32_t Index, SDL_Surface* Image)
+{
+	const uint64_t StartNS = SDL_GetTicksNS();
+	const std::string& AssetID = TextureAssetIDs[Index];
+	AssetRecord& Record = Records[AssetID];
+
+	const SDL_PropertiesID RendererProperties = SDL_GetRendererProperties(LazyRenderer);
+	const int PageSize = static_cast<int>((std::min)(static_cast<Sint64>(MaxAtlasPageSize), SDL_GetNumberProperty(RendererProperties, SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, MaxAtlasPageSize)));
+	const int PaddedWidth = Image->w + AtlasPadding * 2;
+	const int PaddedHeight = Image->h + AtlasPadding * 2;
+	if (PaddedWidth > PageSize || PaddedHeight > PageSize)
+	{
+		SDL_Texture* Texture = SDL_CreateTextureFromSurface(LazyRenderer, Image);
+		if (!Texture)
+		{
+			spdlog::error("Could not create texture {}: {}", AssetID, SDL_GetError());
+			TextureSlots[Index].IsLoadable = false;
+			return;
+		}
+
+		Textures[AssetID] = Texture;
+		TextureRegions[Index] = TextureRegion{ Texture, { 0.0f, 0.0f, static_cast<float>(Image->w), static_cast<float>(Image->h) } };
+		Record.ResidentBytes = static_cast<size_t>(Image->w) * Image->h * 4;
+		Record.AtlasPage = -1;
+		ResidentTextureBytes += Record.ResidentBytes;
+		spdlog::info("Texture {} made resident in {:.2f} ms", AssetID, MillisecondsSince(StartNS));
+		return;
+	}
+
+	int X = 0;
+	int Y = 0;
+	size_t Page = 0;
+	while (Page < AtlasPages.size() && !(AtlasPages[Page].Packer && AtlasPages[Page].Packer->Insert(PaddedWidth, PaddedHeight, X, Y)))
+	{
+		++Page;
+	}
+	if (Page == AtlasPages.size())
+	{
+		SDL_Texture* PageTexture = SDL_CreateTexture(LazyRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, PageSize, PageSize);
+		if (!PageTexture)
+		{
+			spdlog::error("Could not create an atlas page for texture {}: {}", AssetID, SDL_GetError());
+			TextureSlots[Index].IsLoadable = false;
+			return;
+		}
+
+		// Empty slots left by released pages are reused before the list grows.
+		Page = 0;
+		while (Page < AtlasPages.size() && AtlasPages[Page].Texture)
+		{
+			++Page;
+		}
+		if (Page == AtlasPages.size())
+		{
+			AtlasPages.emplace_back();
+		}
+
+		AtlasPage& NewPage = AtlasPages[Page];
+		NewPage.Texture = PageTexture;
+		NewPage.Bytes = static_cast<size_t>(PageSize) * PageSize * 4;
+		ResidentTextureBytes += NewPage.Bytes;
+		NewPage.Packer = std::make_unique<SkylinePacker>(PageSize, PageSize);
+		NewPage.Packer->Insert(PaddedWidth, PaddedHeight, X, Y);
+	}
+
+	// Uploaded with its padding, so the extruded edges and the transparent border come along.
+	SDL_Surface* Padded = SDL_CreateSurface(PaddedWidth, PaddedHeight, SDL_PIXELFORMAT_RGBA32);
+	SDL_FillSurfaceRect(Padded, nullptr, 0);
+	SDL_SetSurfaceBlendMode(Image, SDL_BLENDMODE_NONE);
+	const SDL_Rect Rect = { X + AtlasPadding, Y + AtlasPadding, Image->w, Image->h };
+	BlitExtruded(Image, Padded, { AtlasPadding, AtlasPadding, Image->w, Image->h });
+	const SDL_Rect PaddedRect = { X, Y, PaddedWidth, PaddedHeight };
+	SDL_UpdateTexture(AtlasPages[Page].Texture, &PaddedRect, Padded->pixels, Padded->pitch);
+	SDL_DestroySurface(Padded);
+
+	TextureRegions[Index] = MakeRegion(AtlasPages[Page].Texture, Rect);
+	++AtlasPages[Page].RegionCount;
+	Record.ResidentBytes = static_cast<size_t>(Image->w) * Image->h * 4;
+	Record.AtlasPage = static_cast<int>(Page);
+	spdlog::info("Texture {} made resident on atlas page {} in {:.2f} ms", AssetID, Page, MillisecondsSince(StartNS));
+}
+
+// Evicts whole pages, or standalone textures, least recently used first. Every texture on an evicted
+// page goes back to being registered only. The candidates are gathered in one pass over the records
+// and then evicted in order, so evicting many textures costs no more than evicting one.
+void AssetManager::EvictUnusedTextures()
+{
+	if (ResidentTextureBytes <= TextureBudgetBytes)
+	{
+		HasWarnedOverBudget = false;
+		return;
+	}
+
+	struct EvictionCandidate
+	{
+		uint64_t LastUsed = 0;
+		// An atlas page, or -1 for the standalone texture named by AssetID.
+		int Page = -1;
+		const std::string* AssetID = nullptr;
+	};
+
+	std::vector<EvictionCandidate> Candidates;
+	std::vector<uint64_t> PageLastUsed(AtlasPages.size(), 0);
+	std::vector<std::vector<std::pair<uint32_t, AssetRecord*>>> PageTextures(AtlasPages.size());
+	for (auto& [AssetID, Record] : Records)
+	{
+		if (Record.Type != AssetType::Texture || Record.ResidentBytes == 0)
+		{
+			continue;
+		}
+
+		const uint32_t Index = TextureHandles.at(AssetID);
+		if (Record.AtlasPage >= 0)
+		{
+			PageTextures[Record.AtlasPage].emplace_back(Index, &Record);
+		}
+		if (!TextureSlots[Index].IsLoadable)
+		{
+			// Loaded eagerly, so there is nothing to reload it from.
+			if (Record.AtlasPage >= 0)
+			{
+				PageLastUsed[Record.AtlasPage] = UINT64_MAX;
+			}
+			continue;
+		}
+
+		const uint64_t LastUsed = TextureSlots[Index].LastUsedFrame;
+		if (Record.AtlasPage >= 0)
+		{
+			PageLastUsed[Record.AtlasPage] = (std::max)(PageLastUsed[Record.AtlasPage], LastUsed);
+		}
+		else
+		{
+			Candidates.push_back(EvictionCandidate{ LastUsed, -1, &AssetID });
+		}
+	}
+	for (size_t Page = 0; Page < AtlasPages.size(); ++Page)
+	{
+		if (AtlasPages[Page].Packer && AtlasPages[Page].Texture && PageLastUsed[Page] != UINT64_MAX)
+		{
+			Candidates.push_back(EvictionCandidate{ PageLastUsed[Page], static_cast<int>(Page), nullptr });
+		}
+	}
+	std::sort(Candidates.begin(), Candidates.end(), [](const EvictionCandidate& A, const EvictionCandidate& B)
+	{
+		return A.LastUsed < B.LastUsed;
+	});
+
+	for (const EvictionCandidate& Candidate : Candidates)
+	{
+		if (ResidentTextureBytes <= TextureBudgetBytes || Candidate.LastUsed + MinEvictionAgeFrames > ResidencyFrame)
+		{
+			break;
+		}
+
+		if (Candidate.Page < 0)
+		{
+			const auto Texture = Textures.find(*Candidate.AssetID);
+			SDL_DestroyTexture(Texture->second);
+			Textures.erase(Texture);
+			TextureRegions[TextureHandles.at(*Candidate.AssetID)] = TextureRegion();
+			AssetRecord& Record = Records[*Candidate.AssetID];
+			ResidentTextureBytes -= Record.ResidentBytes;
+			Record.ResidentBytes = 0;
+			spdlog::info("Texture {} evicted after {} unused frames", *Candidate.AssetID, ResidencyFrame - Candidate.LastUsed);
+		}
+		else
+		{
+			for (const auto& [Index, Record] : PageTextures[Candidate.Page])
+			{
+				TextureRegions[Index] = TextureRegion();
+				Record->ResidentBytes = 0;
+				Record->AtlasPage = -1;
+			}
+			SDL_DestroyTexture(AtlasPages[Candidate.Page].Texture);
+			ResidentTextureBytes -= AtlasPages[Candidate.Page].Bytes;
+			AtlasPages[Candidate.Page] = AtlasPage();
+			spdlog::info("Atlas page {} evicted after {} unused frames", Candidate.Page, ResidencyFrame - Candidate.LastUsed);
+		}
+	}
+
+	if (ResidentTextureBytes > TextureBudgetBytes)
+	{
+		if (!HasWarnedOverBudget)
+		{
+			spdlog::warn("Resident textures use {} MB, over the {} MB budget, but all were drawn recently", ResidentTextureBytes / (1024 * 1024), TextureBudgetBytes / (1024 * 1024));
+			HasWarnedOverBudget = true;
+		}
+		return;
+	}
+	HasWarnedOverBudget = false;
+}
+
+void AssetManager::WaitForStreaming()
+{
+	if (Streaming)
+	{
+		Streaming->Wait();
 	}
 }
 
 void AssetManager::AddFont(const std::string &AssetID, const std::string &FilePath, uint8_t FontSize)
 {
+	if (AddToLevel(AssetID))
+	{
+		return;
+	}
+
 	Fonts.emplace(AssetID, TTF_OpenFont(FilePath.c_str(), static_cast<float>(FontSize)));
+	std::error_code Error;
+	const uintmax_t FileSize = std::filesystem::file_size(FilePath, Error);
+	Records[AssetID] = AssetRecord{ AssetType::Font, 0, Error ? 0 : static_cast<size_t>(FileSize), -1, nullptr };
+	AddToLevel(AssetID);
 
 	spdlog::info("Font with AssetID: {} added", AssetID);
 }
 
+void AssetManager::QueueFont(const std::string& AssetID, const std::string& FilePath, uint8_t FontSize, AssetLoader& Loader)
+{
+	if (AddToLevel(AssetID))
+	{
+		return;
+	}
+
+	PendingFonts.push_back(std::make_unique<PendingFont>());
+	PendingFont* Font = PendingFonts.back().get();
+	Font->AssetID = AssetID;
+	Font->FilePath = FilePath;
+	Font->FontSize = FontSize;
+
+	const uint8_t* Data = nullptr;
+	if (const AssetArchiveEntry* Entry = FindPackedEntry(FilePath, &Data))
+	{
+		Font->Data = const_cast<uint8_t*>(Data);
+		Font->Size = static_cast<size_t>(Entry->DataSize);
+		Font->IsMapped = true;
+		return;
+	}
+
+	Loader.Enqueue([Font]()
+	{
+		const uint64_t StartNS = SDL_GetTicksNS();
+		Font->Data = SDL_LoadFile(Font->FilePath.c_str(), &Font->Size);
+		Font->ReadMilliseconds = MillisecondsSince(StartNS);
+	});
+}
+
+void AssetManager::FinishLoading(AssetLoader& Loader)
+{
+	Loader.Wait();
+
+	for (const std::unique_ptr<PendingFont>& Font : PendingFonts)
+	{
+		if (!Font->Data)
+		{
+			spdlog::error("Could not read font {}", Font->FilePath);
+			continue;
+		}
+		void* OwnedData = Font->IsMapped ? nullptr : Font->Data;
+		if (AddToLevel(Font->AssetID))
+		{
+			SDL_free(OwnedData);
+			continue;
+		}
+
+		const uint64_t StartNS = SDL_GetTicksNS();
+		TTF_Font* Opened = TTF_OpenFontIO(SDL_IOFromConstMem(Font->Data, Font->Size), true, static_cast<float>(Font->FontSize));
+		if (!Opened)
+		{
+			spdlog::error("Could not open font {}: {}", Font->FilePath, SDL_GetError());
+			SDL_free(OwnedData);
+			continue;
+		}
+
+		// Fonts opened from memory keep reading their file data, so the record owns it until the font is closed.
+		Fonts.emplace(Font->AssetID, Opened);
+		Records[Font->AssetID] = AssetRecord{ AssetType::Font, 0, Font->Size, -1, OwnedData };
+		AddToLevel(Font->AssetID);
+		spdlog::info("Font {} read in {:.2f} ms, opened in {:.2f} ms", Font->AssetID, Font->ReadMilliseconds, MillisecondsSince(StartNS));
+	}
+	PendingFonts.clear();
+}
+
 TTF_Font *AssetManager::GetFont(const std::string& AssetID)
 {
 	return Fonts[AssetID];
 }
+
+const GlyphAtlas* AssetManager::GetGlyphAtlas(SDL_Renderer* Renderer, const std::string& FontID)
+{
+	TTF_Font* Font = GetFont(FontID);
+	if (!Font)
+	{
+		return nullptr;
+	}
+
+	const auto [Atlas, IsNew] = GlyphAtlases.try_emplace({ FontID, TTF_GetFontSize(Font) });
+	if (IsNew && !Atlas->second.Build(Renderer, Font))
+	{
+		spdlog::error("Could not build glyph atlas for font {}", FontID);
+	}
+	return &Atlas->second;
+}
@@ -1,10 +1,62 @@
 #pragma once
 
+#include "../Render/GlyphAtlas.hpp"
+#include "AssetArchive.hpp"
+#include "AssetLoader.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureHandle.hpp"
+
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
+#include <set>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Where an asset's pixels live: a standalone texture or a rectangle inside an atlas page.
+struct TextureRegion
+{
+	SDL_Texture* Texture = nullptr;
+	SDL_FRect Rect = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+enum class AssetType
+{
+	Texture,
+	Font
+};
 
+// Bookkeeping for one resident asset. It is unloaded as soon as its reference count drops to zero.
+struct AssetRecord
+{
+	AssetType Type = AssetType::Texture;
+	uint32_t RefCount = 0;
+	// Texture pixels (its share of the page for atlas regions) or the font file FreeType reads from.
+	size_t ResidentBytes = 0;
+	// Index into the atlas pages, or -1 for a standalone texture.
+	int AtlasPage = -1;
+	void* FontData = nullptr;
+};
+
+// What LoadLevelAssets did with the previous level's assets and the new level's.
+struct LevelAssetCounts
+{
+	size_t Kept = 0;
+	size_t Released = 0;
+	size_t Loaded = 0;
+};
+
+struct FontFile
+{
+	std::string AssetID;
+	std::string FilePath;
+	uint8_t FontSize = 0;
+};
 
 class AssetManager
 {
@@ -14,14 +66,156 @@ public:
 
 	void ClearAssets();
 
+	// Swaps the level that owns assets. Assets the new level shares with the previous one keep their
+	// reference, the previous level's other assets are released before anything is decoded, and only
+	// assets that are not resident yet are loaded. With lazy textures, new textures are only registered.
+	LevelAssetCounts LoadLevelAssets(SDL_Renderer* Renderer, const std::vector<std::pair<std::string, std::string>>& TextureFiles, const std::vector<FontFile>& FontFiles, AssetLoader& Loader);
+	// Maps a packed archive. Files it contains are read from the mapping instead of the loose files at
+	// the same paths; anything missing from it, or edited since it was packed, still loads from disk.
+	// Archives stay mapped until the assets are cleared, since fonts keep reading from them.
+	bool MountArchive(const std::string& FilePath);
+	// The packed bytes of a file, or an empty view when it only exists as a loose file.
+	std::string_view GetPackedFile(const std::string& FilePath) const;
+
+	// Extra references for owners that outlive a level. Acquire returns false if the asset is not resident.
+	bool AcquireAsset(const std::string& AssetID);
+	void ReleaseAsset(const std::string& AssetID);
+	const std::map<std::string, AssetRecord>& GetAssetRecords() const { return Records; }
+	size_t GetAtlasPageBytes() const;
+	size_t GetAtlasPageCount() const;
+
+	// Lazy residency: textures are registered when a level loads, then decoded and uploaded the first
+	// time they are drawn or requested. While resident textures exceed BudgetBytes, the atlas pages
+	// that have gone unused longest are evicted; their textures reload on their next use. Sprites
+	// within PrefetchRadius pixels of the camera are decoded in the background; 0 turns that off.
+	void EnableLazyTextures(SDL_Renderer* Renderer, size_t BudgetBytes, float PrefetchRadius);
+	bool HasLazyTextures() const { return LazyRenderer != nullptr; }
+	float GetPrefetchRadius() const { return PrefetchRadius; }
+	// Queues a background decode, so the texture is resident by the time it becomes visible.
+	void PrefetchTexture(TextureHandle Handle);
+	// Once per frame on the renderer's thread: uploads finished prefetches and evicts over budget.
+	void UpdateTextureResidency();
+	size_t GetResidentTextureBytes() const;
+	size_t GetTextureBudget() const { return TextureBudgetBytes; }
+
 	void AddTexture(SDL_Renderer* Renderer, const std::string& AssetID, const std::string& FilePath);
-	SDL_Texture* GetTexture(const std::string& AssetID) const;
+	// Packs every (AssetID, FilePath) pair into shared atlas pages. The layout and page pixels are
+	// cached under ./cache/atlas, keyed by the contents of the input files. Files are hashed and
+	// decoded on the loader's workers; only the page uploads run on the calling thread.
+	void AddTextureAtlas(SDL_Renderer* Renderer, const std::vector<std::pair<std::string, std::string>>& Files, AssetLoader& Loader);
+	// Lazy textures are loaded on the spot if they are not resident yet.
+	SDL_Texture* GetTexture(const std::string& AssetID);
+	const TextureRegion& GetTextureRegion(const std::string& AssetID);
+
+	// Handles are interned on first request and stay valid for the lifetime of the manager;
+	// ClearAssets only empties their regions. Resolve them once when a component is set.
+	TextureHandle GetTextureHandle(const std::string& AssetID);
+	const TextureRegion& GetTextureRegion(TextureHandle Handle)
+	{
+		const uint32_t Index = Handle.Index < TextureRegions.size() ? Handle.Index : 0;
+		TextureSlots[Index].LastUsedFrame = ResidencyFrame;
+		if (!TextureRegions[Index].Texture && TextureSlots[Index].IsLoadable)
+		{
+			MakeResident(Index);
+		}
+		return TextureRegions[Index];
+	}
+	// The string id behind a handle, for tooling and log messages.
+	const std::string& GetTextureAssetID(TextureHandle Handle) const;
 
 	void AddFont(const std::string& AssetID, const std::string& FilePath, uint8_t FontSize);
+	// Reads the font file on one of the loader's workers. The font is opened by FinishLoading, since
+	// SDL_ttf shares a single FreeType library between all fonts.
+	void QueueFont(const std::string& AssetID, const std::string& FilePath, uint8_t FontSize, AssetLoader& Loader);
+	// Completion barrier for everything queued on the loader, after which queued fonts are usable.
+	void FinishLoading(AssetLoader& Loader);
 	TTF_Font* GetFont(const std::string& AssetID);
+	// Built on first use for each (font, point size) and kept until the assets are cleared.
+	const GlyphAtlas* GetGlyphAtlas(SDL_Renderer* Renderer, const std::string& FontID);
 
 private:
+	struct PendingFont
+	{
+		std::string AssetID;
+		std::string FilePath;
+		uint8_t FontSize = 0;
+		void* Data = nullptr;
+		size_t Size = 0;
+		double ReadMilliseconds = 0.0;
+		// Points into a mounted archive rather than a buffer of our own.
+		bool IsMapped = false;
+	};
+
+	bool LoadCachedAtlas(SDL_Renderer* Renderer, uint64_t Key, const std::vector<std::pair<std::string, std::string>>& Files, AssetLoader& Loader);
+	void AddTextureFromSurface(SDL_Renderer* Renderer, const std::string& AssetID, SDL_Surface* Surface);
+	// Searches the mounted archives, newest first.
+	const AssetArchiveEntry* FindPackedEntry(const std::string& FilePath, const uint8_t** OutData) const;
+	// Wraps packed pixels in a surface without copying them, or loads the loose file.
+	SDL_Surface* LoadTextureSurface(const std::string& FilePath) const;
+	size_t AddAtlasPage(SDL_Texture* Texture);
+	void AddAtlasRegion(const std::string& AssetID, size_t Page, const SDL_Rect& Rect);
+	uint32_t InternTexture(const std::string& AssetID);
+	// Gives the current level its single reference to a resident asset; false if it is not resident.
+	bool AddToLevel(const std::string& AssetID);
+	void UnloadAsset(const std::string& AssetID, const AssetRecord& Record);
+	void RegisterTexture(const std::string& AssetID, const std::string& FilePath);
+	void MakeResident(uint32_t Index);
+	void UploadLazyTexture(uint32_t Index, SDL_Surface* Image);
+	void EvictUnusedTextures();
+	void WaitForStreaming();
+
+	struct AtlasPage
+	{
+		SDL_Texture* Texture = nullptr;
+		uint32_t RegionCount = 0;
+		size_t Bytes = 0;
+		// Only pages that lazy textures are added to one at a time have a packer.
+		std::unique_ptr<SkylinePacker> Packer;
+	};
+
+	// Lazy residency state, indexed by TextureHandle::Index like the regions.
+	struct TextureSlot
+	{
+		std::string FilePath;
+		uint64_t LastUsedFrame = 0;
+		// Bumped when the texture is unregistered, so a prefetch finishing afterwards is dropped.
+		uint32_t Generation = 0;
+		bool IsLoadable = false;
+		bool IsPending = false;
+	};
+
+	struct StreamedTexture
+	{
+		uint32_t Index = 0;
+		uint32_t Generation = 0;
+		SDL_Surface* Image = nullptr;
+	};
+
 	std::map<std::string, SDL_Texture*> Textures;
+	// Released pages stay as empty slots so the page indices in the records remain stable.
+	std::vector<AtlasPage> AtlasPages;
+	// Indexed by TextureHandle::Index; slot 0 is the empty region for unknown textures.
+	std::vector<TextureRegion> TextureRegions;
+	std::vector<std::string> TextureAssetIDs;
+	std::vector<TextureSlot> TextureSlots;
+	std::map<std::string, uint32_t> TextureHandles;
 	std::map<std::string, TTF_Font*> Fonts;
-	// TODO: Add support for sounds.
-};
\ No newline at end of file
+	// Boxed so workers can keep writing to an entry while more fonts are queued.
+	std::vector<std::unique_ptr<PendingFont>> PendingFonts;
+	std::map<std::pair<std::string, float>, GlyphAtlas> GlyphAtlases;
+	std::map<std::string, AssetRecord> Records;
+	std::vector<std::unique_ptr<AssetArchive>> Archives;
+	std::set<std::string> LevelAssetIDs;
+
+	SDL_Renderer* LazyRenderer = nullptr;
+	size_t TextureBudgetBytes = 0;
+	float PrefetchRadius = 0.0f;
+	uint64_t ResidencyFrame = 0;
+	// Atlas pages plus standalone textures, kept up to date as they are created and destroyed.
+	size_t ResidentTextureBytes = 0;
+	bool HasWarnedOverBudget = false;
+	// Prefetch decodes run here and hand their surfaces back through StreamedTextures.
+	std::unique_ptr<AssetLoader> Streaming;
+	std::mutex StreamingMutex;
+	std::vector<StreamedTexture> StreamedTextures;
+};
@@ -0,0 +1,236 @@
+#include "TextureAtlas.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <utility>
+
+static constexpr uint64_t FnvOffsetBasis = 14695981039346656037ull;
+static constexpr uint64_t FnvPrime = 1099511628211ull;
+static constexpr int AtlasLayoutVersion = 1;
+
+SkylinePacker::SkylinePacker(int Width, int Height)
+	: Width(Width), Height(Height)
+{
+	Skyline.push_back({ 0, 0, Width });
+}
+
+int SkylinePacker::FindPosition(size_t Index, int Width, int Height) const
+{
+	const int X = Skyline[Index].X;
+	if (X + Width > this->Width)
+	{
+		return -1;
+	}
+
+	int Y = 0;
+	int RemainingWidth = Width;
+	for (size_t i = Index; RemainingWidth > 0; ++i)
+	{
+		if (i == Skyline.size())
+		{
+			return -1;
+		}
+
+		Y = (std::max)(Y, Skyline[i].Y);
+		if (Y + Height > this->Height)
+		{
+			return -1;
+		}
+		RemainingWidth -= Skyline[i].Width;
+	}
+	return Y;
+}
+
+bool SkylinePacker::Insert(int Width, int Height, int& OutX, int& OutY)
+{
+	size_t BestIndex = Skyline.size();
+	int BestBottom = this->Height + 1;
+	int BestX = 0;
+	int BestY = 0;
+	for (size_t i = 0; i < Skyline.size(); ++i)
+	{
+		const int Y = FindPosition(i, Width, Height);
+		if (Y >= 0 && Y + Height < BestBottom)
+		{
+			BestIndex = i;
+			BestBottom = Y + Height;
+			BestX = Skyline[i].X;
+			BestY = Y;
+		}
+	}
+
+	if (BestIndex == Skyline.size())
+	{
+		return false;
+	}
+
+	// The new segment covers the placed rectangle; segments it shadows are trimmed or removed.
+	Skyline.insert(Skyline.begin() + BestIndex, { BestX, BestBottom, Width });
+	for (size_t i = BestIndex + 1; i < Skyline.size();)
+	{
+		const int PreviousEnd = Skyline[i - 1].X + Skyline[i - 1].Width;
+		if (Skyline[i].X >= PreviousEnd)
+		{
+			break;
+		}
+
+		const int Shrink = PreviousEnd - Skyline[i].X;
+		Skyline[i].X += Shrink;
+		Skyline[i].Width -= Shrink;
+		if (Skyline[i].Width <= 0)
+		{
+			Skyline.erase(Skyline.begin() + i);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	for (size_t i = 0; i + 1 < Skyline.size();)
+	{
+		if (Skyline[i].Y == Skyline[i + 1].Y)
+		{
+			Skyline[i].Width += Skyline[i + 1].Width;
+			Skyline.erase(Skyline.begin() + i + 1);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	OutX = BestX;
+	OutY = BestY;
+	return true;
+}
+
+AtlasLayout PackAtlas(const std::vector<std::string>& AssetIDs, const std::vector<SDL_Point>& Sizes, int PageWidth, int PageHeight)
+{
+	AtlasLayout Layout;
+	Layout.PageWidth = PageWidth;
+	Layout.PageHeight = PageHeight;
+	Layout.Placements.resize(AssetIDs.size());
+
+	std::vector<size_t> Order(AssetIDs.size());
+	std::iota(Order.begin(), Order.end(), size_t{ 0 });
+	std::sort(Order.begin(), Order.end(), [&](size_t A, size_t B)
+	{
+		if (Sizes[A].y != Sizes[B].y)
+		{
+			return Sizes[A].y > Sizes[B].y;
+		}
+		if (Sizes[A].x != Sizes[B].x)
+		{
+			return Sizes[A].x > Sizes[B].x;
+		}
+		return AssetIDs[A] < AssetIDs[B];
+	});
+
+	std::vector<SkylinePacker> Pages;
+	for (const size_t Index : Order)
+	{
+		AtlasPlacement& Placement = Layout.Placements[Index];
+		Placement.AssetID = AssetIDs[Index];
+
+		const int PaddedWidth = Sizes[Index].x + AtlasPadding * 2;
+		const int PaddedHeight = Sizes[Index].y + AtlasPadding * 2;
+		if (PaddedWidth > PageWidth || PaddedHeight > PageHeight)
+		{
+			continue;
+		}
+
+		int X = 0;
+		int Y = 0;
+		size_t Page = 0;
+		while (Page < Pages.size() && !Pages[Page].Insert(PaddedWidth, PaddedHeight, X, Y))
+		{
+			++Page;
+		}
+		if (Page == Pages.size())
+		{
+			Pages.emplace_back(PageWidth, PageHeight);
+			Pages.back().Insert(PaddedWidth, PaddedHeight, X, Y);
+		}
+
+		Placement.Page = static_cast<int>(Page);
+		Placement.Rect = { X + AtlasPadding, Y + AtlasPadding, Sizes[Index].x, Sizes[Index].y };
+	}
+
+	Layout.PageCount = static_cast<int>(Pages.size());
+	return Layout;
+}
+
+uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed)
+{
+	uint64_t Hash = Seed == 0 ? FnvOffsetBasis : Seed;
+	const auto* Bytes = static_cast<const uint8_t*>(Data);
+	for (size_t i = 0; i < Size; ++i)
+	{
+		Hash ^= Bytes[i];
+		Hash *= FnvPrime;
+	}
+	return Hash;
+}
+
+uint64_t HashFile(const std::string& FilePath, uint64_t Seed)
+{
+	std::ifstream File(FilePath, std::ios::binary);
+	uint64_t Hash = Seed;
+	char Buffer[16384];
+	while (File.read(Buffer, sizeof(Buffer)) || File.gcount() > 0)
+	{
+		Hash = HashBytes(Buffer, static_cast<size_t>(File.gcount()), Hash);
+	}
+	return Hash;
+}
+
+bool LoadAtlasLayout(const std::string& FilePath, uint64_t Key, AtlasLayout& OutLayout)
+{
+	std::ifstream File(FilePath);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	std::string Magic;
+	int Version = 0;
+	size_t PlacementCount = 0;
+	AtlasLayout Layout;
+	File >> Magic >> Version >> Layout.Key >> Layout.PageWidth >> Layout.PageHeight >> Layout.PageCount >> PlacementCount;
+	if (!File || Magic != "rlatlas" || Version != AtlasLayoutVersion || Layout.Key != Key)
+	{
+		return false;
+	}
+
+	Layout.Placements.resize(PlacementCount);
+	for (AtlasPlacement& Placement : Layout.Placements)
+	{
+		File >> Placement.AssetID >> Placement.Page >> Placement.Rect.x >> Placement.Rect.y >> Placement.Rect.w >> Placement.Rect.h;
+	}
+	if (!File)
+	{
+		return false;
+	}
+
+	OutLayout = std::move(Layout);
+	return true;
+}
+
+bool SaveAtlasLayout(const std::string& FilePath, const AtlasLayout& Layout)
+{
+	std::ofstream File(FilePath, std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File << "rlatlas " << AtlasLayoutVersion << '\n';
+	File << Layout.Key << ' ' << Layout.PageWidth << ' ' << Layout.PageHeight << ' ' << Layout.PageCount << ' ' << Layout.Placements.size() << '\n';
+	for (const AtlasPlacement& Placement : Layout.Placements)
+	{
+		File << Placement.AssetID << ' ' << Placement.Page << ' ' << Placement.Rect.x << ' ' << Placement.Rect.y << ' ' << Placement.Rect.w << ' ' << Placement.Rect.h << '\n';
+	}
+	return static_cast<bool>(File);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Skyline bottom-left rectangle packer for a single atlas page.
+class SkylinePacker
+{
+public:
+	SkylinePacker(int Width, int Height);
+
+	bool Insert(int Width, int Height, int& OutX, int& OutY);
+
+private:
+	struct Segment
+	{
+		int X;
+		int Y;
+		int Width;
+	};
+
+	// Returns the lowest Y at which a Width x Height rectangle fits starting at Skyline[Index], or -1.
+	int FindPosition(size_t Index, int Width, int Height) const;
+
+	int Width;
+	int Height;
+	std::vector<Segment> Skyline;
+};
+
+struct AtlasPlacement
+{
+	std::string AssetID;
+	// -1 when the image is larger than a page and has to stay a texture of its own.
+	int Page = -1;
+	SDL_Rect Rect = { 0, 0, 0, 0 };
+};
+
+struct AtlasLayout
+{
+	uint64_t Key = 0;
+	int PageWidth = 0;
+	int PageHeight = 0;
+	int PageCount = 0;
+	std::vector<AtlasPlacement> Placements;
+};
+
+inline constexpr int AtlasPadding = 2;
+
+// Packs the images tallest first. Every rectangle is surrounded by AtlasPadding pixels, the inner
+// one of which is filled with the image's edge so linear filtering does not bleed in transparency.
+AtlasLayout PackAtlas(const std::vector<std::string>& AssetIDs, const std::vector<SDL_Point>& Sizes, int PageWidth, int PageHeight);
+
+// FNV-1a, used to key the on-disk cache by the contents of every packed file.
+uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed);
+uint64_t HashFile(const std::string& FilePath, uint64_t Seed);
+
+bool LoadAtlasLayout(const std::string& FilePath, uint64_t Key, AtlasLayout& OutLayout);
+bool SaveAtlasLayout(const std::string& FilePath, const AtlasLayout& Layout);
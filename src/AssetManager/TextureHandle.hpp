@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Dense index into the AssetManager texture table. Index 0 is the empty slot handed out for
+// unknown textures, so a default-constructed handle simply draws nothing.
+struct TextureHandle
+{
+	uint32_t Index = 0;
+
+	bool IsValid() const
+	{
+		return Index != 0;
+	}
+
+	bool operator==(const TextureHandle& Other) const = default;
+};
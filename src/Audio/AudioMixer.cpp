@@ -0,0 +1,604 @@
+#include "AudioMixer.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// How often the streamer tops up the rings; a ring holds STREAM_RING_FRAMES, far more than this.
+constexpr auto STREAM_REFILL_INTERVAL = std::chrono::milliseconds(10);
+constexpr size_t STREAM_READ_BYTES = 16 * 1024;
+constexpr size_t STREAM_DECODE_FRAMES = 4096;
+constexpr int MIX_FRAME_BYTES = MIX_CHANNELS * sizeof(float);
+
+static uint16_t ReadLE16(const uint8_t* Bytes)
+{
+	return static_cast<uint16_t>(Bytes[0] | (Bytes[1] << 8));
+}
+
+static uint32_t ReadLE32(const uint8_t* Bytes)
+{
+	return static_cast<uint32_t>(Bytes[0]) | (static_cast<uint32_t>(Bytes[1]) << 8) | (static_cast<uint32_t>(Bytes[2]) << 16) | (static_cast<uint32_t>(Bytes[3]) << 24);
+}
+
+// Walks the RIFF chunks up to the sample data, leaving File positioned at its start. Only PCM and
+// float samples are streamed; compressed WAVs have to be loaded as effects, which SDL_LoadWAV decodes.
+static bool ReadWaveHeader(SDL_IOStream* File, SDL_AudioSpec& Spec, uint64_t& DataBytes)
+{
+	uint8_t Header[12];
+	if (SDL_ReadIO(File, Header, sizeof(Header)) != sizeof(Header) || std::memcmp(Header, "RIFF", 4) != 0 || std::memcmp(Header + 8, "WAVE", 4) != 0)
+	{
+		return false;
+	}
+
+	Spec.format = SDL_AUDIO_UNKNOWN;
+	uint8_t Chunk[8];
+	while (SDL_ReadIO(File, Chunk, sizeof(Chunk)) == sizeof(Chunk))
+	{
+		const uint32_t ChunkBytes = ReadLE32(Chunk + 4);
+		if (std::memcmp(Chunk, "data", 4) == 0)
+		{
+			DataBytes = ChunkBytes;
+			return Spec.format != SDL_AUDIO_UNKNOWN;
+		}
+
+		int64_t SkipBytes = ChunkBytes + (ChunkBytes & 1);
+		if (std::memcmp(Chunk, "fmt ", 4) == 0 && ChunkBytes >= 16)
+		{
+			// WAVE_FORMAT_EXTENSIBLE keeps the actual format tag at the start of its sub-format GUID.
+			uint8_t Format[26] = {};
+			const size_t FormatBytes = (std::min)(static_cast<size_t>(ChunkBytes), sizeof(Format));
+			if (SDL_ReadIO(File, Format, FormatBytes) != FormatBytes)
+			{
+				return false;
+			}
+			SkipBytes -= FormatBytes;
+
+			const uint16_t Tag = ReadLE16(Format) == 0xFFFE && FormatBytes == sizeof(Format) ? ReadLE16(Format + 24) : ReadLE16(Format);
+			const uint16_t Bits = ReadLE16(Format + 14);
+			Spec.channels = ReadLE16(Format + 2);
+			Spec.freq = static_cast<int>(ReadLE32(Format + 4));
+			Spec.format = SDL_AUDIO_UNKNOWN;
+			if (Tag == 3 && Bits == 32)
+			{
+				Spec.format = SDL_AUDIO_F32LE;
+			}
+			else if (Tag == 1)
+			{
+				Spec.format = Bits == 8 ? SDL_AUDIO_U8 : Bits == 16 ? SDL_AUDIO_S16LE : Bits == 32 ? SDL_AUDIO_S32LE : SDL_AUDIO_UNKNOWN;
+			}
+			if (Spec.channels <= 0 || Spec.freq <= 0)
+			{
+				Spec.format = SDL_AUDIO_UNKNOWN;
+			}
+		}
+
+		if (SkipBytes > 0 && SDL_SeekIO(File, SkipBytes, SDL_IO_SEEK_CUR) < 0)
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+// Linear falloff to silence at SOUND_CULL_DISTANCE.
+static float GetDistanceGain(float DeltaX, float DeltaY)
+{
+	const float Distance = std::sqrt(DeltaX * DeltaX + DeltaY * DeltaY);
+	return (std::max)(0.0f, 1.0f - Distance / SOUND_CULL_DISTANCE);
+}
+
+AudioMixer::AudioMixer()
+{
+}
+
+AudioMixer::~AudioMixer()
+{
+	Close();
+}
+
+bool AudioMixer::Open()
+{
+	if (Device)
+	{
+		return true;
+	}
+
+	// The device starts paused, so every buffer the callback touches is allocated before it first runs.
+	Device = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &MixSpec, &AudioMixer::MixCallback, this);
+	if (!Device)
+	{
+		spdlog::warn("Could not open an audio device, sounds are disabled: {}", SDL_GetError());
+		return false;
+	}
+
+	MixBuffer.assign(MIX_BLOCK_FRAMES * MIX_CHANNELS, 0.0f);
+	for (StreamSlot& Slot : Streams)
+	{
+		Slot.Ring.assign(STREAM_RING_FRAMES * MIX_CHANNELS, 0.0f);
+	}
+	ReadBuffer.resize(STREAM_READ_BYTES);
+	DecodeBuffer.resize(STREAM_DECODE_FRAMES * MIX_CHANNELS);
+
+	IsStreamerStopping = false;
+	Streamer = std::thread(&AudioMixer::RunStreamer, this);
+	SDL_ResumeAudioStreamDevice(Device);
+	spdlog::info("Audio mixer opened at {} Hz with {} voices", MIX_SAMPLE_RATE, MAX_VOICES);
+	return true;
+}
+
+void AudioMixer::Close()
+{
+	if (!Device)
+	{
+		return;
+	}
+
+	// The streamer locks the device stream, so it has to stop before the stream is destroyed.
+	{
+		std::lock_guard<std::mutex> Lock(StreamerMutex);
+		IsStreamerStopping = true;
+	}
+	StreamerWake.notify_all();
+	Streamer.join();
+
+	SDL_DestroyAudioStream(Device);
+	Device = nullptr;
+	for (StreamSlot& Slot : Streams)
+	{
+		CloseStream(Slot);
+	}
+	Voices.fill(Voice());
+	Sounds.clear();
+}
+
+bool AudioMixer::AddSound(const std::string& AssetID, const std::string& FilePath, bool IsStreamed, std::string_view PackedData)
+{
+	if (!Device)
+	{
+		return false;
+	}
+	if (Sounds.contains(AssetID))
+	{
+		return true;
+	}
+
+	Sound NewSound;
+	NewSound.IsStreamed = IsStreamed;
+	NewSound.FilePath = FilePath;
+	NewSound.PackedData = PackedData;
+	if (!IsStreamed)
+	{
+		SDL_AudioSpec SourceSpec;
+		Uint8* Data = nullptr;
+		Uint32 DataBytes = 0;
+		const bool IsLoaded = PackedData.empty()
+			? SDL_LoadWAV(FilePath.c_str(), &SourceSpec, &Data, &DataBytes)
+			: SDL_LoadWAV_IO(SDL_IOFromConstMem(PackedData.data(), PackedData.size()), true, &SourceSpec, &Data, &DataBytes);
+		if (!IsLoaded)
+		{
+			spdlog::error("Could not load sound {}: {}", FilePath, SDL_GetError());
+			return false;
+		}
+
+		Uint8* Converted = nullptr;
+		int ConvertedBytes = 0;
+		const bool IsConverted = SDL_ConvertAudioSamples(&SourceSpec, Data, static_cast<int>(DataBytes), &MixSpec, &Converted, &ConvertedBytes);
+		SDL_free(Data);
+		if (!IsConverted)
+		{
+			spdlog::error("Could not convert sound {}: {}", FilePath, SDL_GetError());
+			return false;
+		}
+
+		const float* Samples = reinterpret_cast<const float*>(Converted);
+		NewSound.Samples.assign(Samples, Samples + ConvertedBytes / sizeof(float));
+		SDL_free(Converted);
+	}
+
+	spdlog::info("Sound {} added ({})", AssetID, IsStreamed ? "streamed" : std::to_string(NewSound.Samples.size() * sizeof(float) / 1024) + " KB");
+	Sounds.emplace(AssetID, std::move(NewSound));
+	return true;
+}
+
+void AudioMixer::ClearSounds()
+{
+	if (!Device)
+	{
+		return;
+	}
+
+	// Holding the streamer's mutex keeps it from reading a sound while the sounds go away.
+	std::lock_guard<std::mutex> Lock(StreamerMutex);
+	StopAll();
+	for (StreamSlot& Slot : Streams)
+	{
+		CloseStream(Slot);
+	}
+	Sounds.clear();
+}
+
+bool AudioMixer::Play(const std::string& AssetID, const SoundParams& Params)
+{
+	if (!Device)
+	{
+		return false;
+	}
+
+	const auto Found = Sounds.find(AssetID);
+	if (Found == Sounds.end())
+	{
+		spdlog::warn("Sound {} is not loaded", AssetID);
+		return false;
+	}
+
+	if (Params.IsPositional && GetDistanceGain(Params.X - ListenerX.load(std::memory_order_relaxed), Params.Y - ListenerY.load(std::memory_order_relaxed)) <= 0.0f)
+	{
+		return false;
+	}
+
+	const Sound& Source = Found->second;
+	SDL_LockAudioStream(Device);
+
+	int Stream = -1;
+	if (Source.IsStreamed)
+	{
+		for (size_t i = 0; i < Streams.size() && Stream < 0; ++i)
+		{
+			Stream = Streams[i].Requested ? -1 : static_cast<int>(i);
+		}
+	}
+
+	// Once every ring is taken, a streamed sound can only replace another streamed voice.
+	const bool IsStealingStream = Source.IsStreamed && Stream < 0;
+	Voice* Target = nullptr;
+	for (Voice& Candidate : Voices)
+	{
+		if (!Candidate.Source && !IsStealingStream)
+		{
+			Target = &Candidate;
+			break;
+		}
+	}
+
+	if (!Target)
+	{
+		for (Voice& Candidate : Voices)
+		{
+			if (IsStealingStream && Candidate.Stream < 0)
+			{
+				continue;
+			}
+			if (!Target || Candidate.Params.Priority < Target->Params.Priority
+				|| (Candidate.Params.Priority == Target->Params.Priority && Candidate.Serial < Target->Serial))
+			{
+				Target = &Candidate;
+			}
+		}
+
+		if (!Target || Target->Params.Priority > Params.Priority)
+		{
+			SDL_UnlockAudioStream(Device);
+			return false;
+		}
+
+		Stream = IsStealingStream ? Target->Stream : Stream;
+		StopVoice(*Target);
+	}
+
+	Target->Source = &Source;
+	Target->Serial = NextSerial++;
+	Target->Cursor = 0;
+	Target->Params = Params;
+	Target->Stream = Stream;
+	if (Stream >= 0)
+	{
+		StreamSlot& Slot = Streams[Stream];
+		Slot.Requested = &Source;
+		Slot.IsLooping = Params.IsLooping;
+		Target->StreamGeneration = ++Slot.Generation;
+	}
+	SDL_UnlockAudioStream(Device);
+
+	if (Stream >= 0)
+	{
+		StreamerWake.notify_one();
+	}
+	return true;
+}
+
+void AudioMixer::StopAll()
+{
+	if (!Device)
+	{
+		return;
+	}
+
+	SDL_LockAudioStream(Device);
+	for (Voice& Voice : Voices)
+	{
+		if (Voice.Source)
+		{
+			StopVoice(Voice);
+		}
+	}
+	SDL_UnlockAudioStream(Device);
+}
+
+void AudioMixer::SetListener(float X, float Y)
+{
+	ListenerX.store(X, std::memory_order_relaxed);
+	ListenerY.store(Y, std::memory_order_relaxed);
+}
+
+void AudioMixer::MixCallback(void* UserData, SDL_AudioStream*, int AdditionalAmount, int)
+{
+	AudioMixer* Mixer = static_cast<AudioMixer*>(UserData);
+	for (int Frames = AdditionalAmount / MIX_FRAME_BYTES; Frames > 0; Frames -= MIX_BLOCK_FRAMES)
+	{
+		Mixer->Mix((std::min)(Frames, MIX_BLOCK_FRAMES));
+	}
+}
+
+void AudioMixer::Mix(int Frames)
+{
+	float* Output = MixBuffer.data();
+	std::fill_n(Output, Frames * MIX_CHANNELS, 0.0f);
+	for (Voice& Voice : Voices)
+	{
+		if (Voice.Source)
+		{
+			MixVoice(Voice, Output, Frames);
+		}
+	}
+
+	for (int i = 0; i < Frames * MIX_CHANNELS; ++i)
+	{
+		Output[i] = std::clamp(Output[i], -1.0f, 1.0f);
+	}
+	SDL_PutAudioStreamData(Device, Output, Frames * MIX_FRAME_BYTES);
+}
+
+void AudioMixer::MixVoice(Voice& Voice, float* Output, int Frames)
+{
+	float LeftGain = Voice.Params.Volume;
+	float RightGain = Voice.Params.Volume;
+	if (Voice.Params.IsPositional)
+	{
+		// Constant-power pan by the horizontal offset; voices out of range keep their place but add nothing.
+		const float DeltaX = Voice.Params.X - ListenerX.load(std::memory_order_relaxed);
+		const float DeltaY = Voice.Params.Y - ListenerY.load(std::memory_order_relaxed);
+		const float Gain = Voice.Params.Volume * GetDistanceGain(DeltaX, DeltaY);
+		const float Angle = (std::clamp(DeltaX / SOUND_CULL_DISTANCE, -1.0f, 1.0f) + 1.0f) * 0.25f * 3.14159265f;
+		LeftGain = Gain * std::cos(Angle);
+		RightGain = Gain * std::sin(Angle);
+	}
+	const bool IsAudible = LeftGain > 0.0f || RightGain > 0.0f;
+
+	if (Voice.Stream >= 0)
+	{
+		StreamSlot& Slot = Streams[Voice.Stream];
+		if (Slot.ReadyGeneration != Voice.StreamGeneration)
+		{
+			return;
+		}
+
+		const bool IsEndOfStream = Slot.IsEndOfStream.load(std::memory_order_acquire);
+		const uint64_t ReadFrame = Slot.ReadFrame.load(std::memory_order_relaxed);
+		const uint64_t WriteFrame = Slot.WriteFrame.load(std::memory_order_acquire);
+		const uint64_t Count = (std::min)(static_cast<uint64_t>(Frames), WriteFrame - ReadFrame);
+		for (uint64_t i = 0; i < Count && IsAudible; ++i)
+		{
+			const float* Frame = &Slot.Ring[((ReadFrame + i) % STREAM_RING_FRAMES) * MIX_CHANNELS];
+			Output[i * MIX_CHANNELS] += Frame[0] * LeftGain;
+			Output[i * MIX_CHANNELS + 1] += Frame[1] * RightGain;
+		}
+		Slot.ReadFrame.store(ReadFrame + Count, std::memory_order_release);
+
+		// An underrun only drops out; the voice ends once the streamer has written the last frame.
+		if (IsEndOfStream && ReadFrame + Count == WriteFrame)
+		{
+			StopVoice(Voice);
+		}
+		return;
+	}
+
+	const std::vector<float>& Samples = Voice.Source->Samples;
+	const size_t FrameCount = Samples.size() / MIX_CHANNELS;
+	int Mixed = 0;
+	while (Mixed < Frames)
+	{
+		if (Voice.Cursor >= FrameCount)
+		{
+			if (!Voice.Params.IsLooping || FrameCount == 0)
+			{
+				StopVoice(Voice);
+				return;
+			}
+			Voice.Cursor = 0;
+		}
+
+		const size_t Count = (std::min)(static_cast<size_t>(Frames - Mixed), FrameCount - Voice.Cursor);
+		const float* Input = &Samples[Voice.Cursor * MIX_CHANNELS];
+		float* Target = &Output[Mixed * MIX_CHANNELS];
+		for (size_t i = 0; i < Count && IsAudible; ++i)
+		{
+			Target[i * MIX_CHANNELS] += Input[i * MIX_CHANNELS] * LeftGain;
+			Target[i * MIX_CHANNELS + 1] += Input[i * MIX_CHANNELS + 1] * RightGain;
+		}
+		Voice.Cursor += Count;
+		Mixed += static_cast<int>(Count);
+	}
+}
+
+void AudioMixer::StopVoice(Voice& Voice)
+{
+	if (Voice.Stream >= 0)
+	{
+		StreamSlot& Slot = Streams[Voice.Stream];
+		Slot.Requested = nullptr;
+		++Slot.Generation;
+	}
+	Voice = AudioMixer::Voice();
+}
+
+void AudioMixer::RunStreamer()
+{
+	std::unique_lock<std::mutex> Lock(StreamerMutex);
+	while (!IsStreamerStopping)
+	{
+		for (StreamSlot& Slot : Streams)
+		{
+			UpdateStream(Slot);
+		}
+		StreamerWake.wait_for(Lock, STREAM_REFILL_INTERVAL);
+	}
+}
+
+void AudioMixer::UpdateStream(StreamSlot& Slot)
+{
+	SDL_LockAudioStream(Device);
+	const uint32_t Generation = Slot.Generation;
+	const Sound* Requested = Slot.Requested;
+	const bool IsLooping = Slot.IsLooping;
+	SDL_UnlockAudioStream(Device);
+
+	if (Generation == Slot.OpenedGeneration)
+	{
+		FillStream(Slot);
+		return;
+	}
+
+	// A new request, or a release. No voice reads the ring until its generation is published, so
+	// the counters can be reset without the lock.
+	CloseStream(Slot);
+	Slot.OpenedGeneration = Generation;
+	if (!Requested)
+	{
+		return;
+	}
+
+	Slot.Source = Requested;
+	Slot.ShouldLoop = IsLooping;
+	Slot.ReadFrame.store(0, std::memory_order_relaxed);
+	Slot.WriteFrame.store(0, std::memory_order_relaxed);
+	Slot.IsEndOfStream.store(false, std::memory_order_relaxed);
+	OpenStream(Slot);
+	FillStream(Slot);
+
+	SDL_LockAudioStream(Device);
+	Slot.ReadyGeneration = Generation;
+	SDL_UnlockAudioStream(Device);
+}
+
+void AudioMixer::OpenStream(StreamSlot& Slot)
+{
+	const Sound& Source = *Slot.Source;
+	Slot.File = Source.PackedData.empty() ? SDL_IOFromFile(Source.FilePath.c_str(), "rb") : SDL_IOFromConstMem(Source.PackedData.data(), Source.PackedData.size());
+
+	SDL_AudioSpec SourceSpec;
+	uint64_t DataBytes = 0;
+	if (Slot.File && ReadWaveHeader(Slot.File, SourceSpec, DataBytes))
+	{
+		Slot.Converter = SDL_CreateAudioStream(&SourceSpec, &MixSpec);
+		Slot.SourceFrameBytes = SDL_AUDIO_BYTESIZE(SourceSpec.format) * SourceSpec.channels;
+		Slot.DataStart = SDL_TellIO(Slot.File);
+		Slot.DataBytes = DataBytes - DataBytes % Slot.SourceFrameBytes;
+		Slot.RemainingBytes = Slot.DataBytes;
+		Slot.IsFlushed = false;
+	}
+
+	if (!Slot.Converter || Slot.DataBytes == 0)
+	{
+		// The voice still gets its generation and ends on the first callback that sees it.
+		spdlog::error("Could not stream sound {}: unsupported or unreadable WAV file", Source.FilePath);
+		Slot.IsEndOfStream.store(true, std::memory_order_release);
+	}
+}
+
+void AudioMixer::FillStream(StreamSlot& Slot)
+{
+	if (!Slot.Converter || Slot.IsEndOfStream.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	const uint64_t DecodeFrames = DecodeBuffer.size() / MIX_CHANNELS;
+	while (true)
+	{
+		const uint64_t WriteFrame = Slot.WriteFrame.load(std::memory_order_relaxed);
+		const uint64_t FreeFrames = STREAM_RING_FRAMES - (WriteFrame - Slot.ReadFrame.load(std::memory_order_acquire));
+		if (FreeFrames == 0)
+		{
+			return;
+		}
+
+		// Converted frames are drained first, so the converter never holds more than one read.
+		const int Wanted = static_cast<int>((std::min)(FreeFrames, DecodeFrames)) * MIX_FRAME_BYTES;
+		const int Decoded = SDL_GetAudioStreamData(Slot.Converter, DecodeBuffer.data(), Wanted);
+		if (Decoded > 0)
+		{
+			const uint64_t Frames = static_cast<uint64_t>(Decoded / MIX_FRAME_BYTES);
+			for (uint64_t i = 0; i < Frames; ++i)
+			{
+				float* Frame = &Slot.Ring[((WriteFrame + i) % STREAM_RING_FRAMES) * MIX_CHANNELS];
+				Frame[0] = DecodeBuffer[i * MIX_CHANNELS];
+				Frame[1] = DecodeBuffer[i * MIX_CHANNELS + 1];
+			}
+			Slot.WriteFrame.store(WriteFrame + Frames, std::memory_order_release);
+			continue;
+		}
+
+		if (Decoded == 0 && Slot.RemainingBytes > 0)
+		{
+			const size_t ChunkBytes = ReadBuffer.size() - ReadBuffer.size() % Slot.SourceFrameBytes;
+			size_t ReadBytes = SDL_ReadIO(Slot.File, ReadBuffer.data(), (std::min)(static_cast<size_t>(Slot.RemainingBytes), ChunkBytes));
+			ReadBytes -= ReadBytes % Slot.SourceFrameBytes;
+			if (ReadBytes == 0)
+			{
+				// A truncated file ends the track rather than looping over nothing.
+				Slot.RemainingBytes = 0;
+				Slot.ShouldLoop = false;
+				continue;
+			}
+			Slot.RemainingBytes -= ReadBytes;
+			SDL_PutAudioStreamData(Slot.Converter, ReadBuffer.data(), static_cast<int>(ReadBytes));
+			continue;
+		}
+
+		if (Decoded == 0 && Slot.ShouldLoop && SDL_SeekIO(Slot.File, Slot.DataStart, SDL_IO_SEEK_SET) >= 0)
+		{
+			Slot.RemainingBytes = Slot.DataBytes;
+			continue;
+		}
+
+		if (Decoded == 0 && !Slot.IsFlushed)
+		{
+			SDL_FlushAudioStream(Slot.Converter);
+			Slot.IsFlushed = true;
+			continue;
+		}
+
+		Slot.IsEndOfStream.store(true, std::memory_order_release);
+		return;
+	}
+}
+
+void AudioMixer::CloseStream(StreamSlot& Slot)
+{
+	if (Slot.Converter)
+	{
+		SDL_DestroyAudioStream(Slot.Converter);
+		Slot.Converter = nullptr;
+	}
+	if (Slot.File)
+	{
+		SDL_CloseIO(Slot.File);
+		Slot.File = nullptr;
+	}
+	Slot.Source = nullptr;
+	Slot.DataBytes = 0;
+	Slot.RemainingBytes = 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+constexpr int MIX_SAMPLE_RATE = 48000;
+constexpr int MIX_CHANNELS = 2;
+// Frames mixed per pass of the device callback; the callback loops until it has covered its request.
+constexpr int MIX_BLOCK_FRAMES = 1024;
+constexpr size_t MAX_VOICES = 32;
+// Streamed voices each own one ring buffer, so at most this many long tracks play at once.
+constexpr size_t MAX_STREAMED_VOICES = 2;
+constexpr int STREAM_RING_FRAMES = MIX_SAMPLE_RATE / 2;
+// Positional voices fade out linearly with their distance to the listener and are not started beyond it.
+constexpr float SOUND_CULL_DISTANCE = 800.0f;
+
+struct SoundParams
+{
+	float Volume = 1.0f;
+	// A full pool steals the lowest priority voice, the oldest among equals, if it is not above this.
+	int Priority = 0;
+	bool IsLooping = false;
+	// Non-positional voices ignore the listener, such as music or interface sounds.
+	bool IsPositional = false;
+	float X = 0.0f;
+	float Y = 0.0f;
+};
+
+// Mixes level sounds into one SDL_AudioStream from SDL's audio thread. Short effects are decoded
+// once to the mix format and kept in memory; streamed tracks are decoded from disk, or from a mapped
+// archive, by a streamer thread into ring buffers that the callback drains. The callback only reads
+// buffers allocated up front. Without an audio device, such as in headless runs, every call is a no-op.
+class AudioMixer
+{
+public:
+	AudioMixer();
+	~AudioMixer();
+
+	AudioMixer(const AudioMixer&) = delete;
+	AudioMixer& operator=(const AudioMixer&) = delete;
+
+	bool Open();
+	void Close();
+	bool IsOpen() const { return Device != nullptr; }
+
+	// PackedData, when not empty, is read instead of FilePath and must outlive the sound. Neither this
+	// nor ClearSounds may race with Play; the level loader calls them before the game runs.
+	bool AddSound(const std::string& AssetID, const std::string& FilePath, bool IsStreamed, std::string_view PackedData = {});
+	void ClearSounds();
+
+	// Safe to call from any thread. Returns false if the sound was culled or no voice could be taken.
+	bool Play(const std::string& AssetID, const SoundParams& Params = SoundParams());
+	void StopAll();
+	void SetListener(float X, float Y);
+
+private:
+	struct Sound
+	{
+		// Interleaved stereo at the mix rate; empty for streamed sounds.
+		std::vector<float> Samples;
+		bool IsStreamed = false;
+		std::string FilePath;
+		std::string_view PackedData;
+	};
+
+	struct Voice
+	{
+		const Sound* Source = nullptr;
+		uint64_t Serial = 0;
+		size_t Cursor = 0;
+		int Stream = -1;
+		uint32_t StreamGeneration = 0;
+		SoundParams Params;
+	};
+
+	// The ring is filled by the streamer thread and drained by the callback, synchronised by the frame counters.
+	struct StreamSlot
+	{
+		// Requests from Play and the callback, guarded by the device stream's lock. Each new request,
+		// including a release, bumps the generation; the streamer publishes the generation it filled the ring for.
+		const Sound* Requested = nullptr;
+		bool IsLooping = false;
+		uint32_t Generation = 0;
+		uint32_t ReadyGeneration = 0;
+
+		std::vector<float> Ring;
+		std::atomic<uint64_t> ReadFrame = 0;
+		std::atomic<uint64_t> WriteFrame = 0;
+		std::atomic<bool> IsEndOfStream = false;
+
+		// Only touched by the streamer thread, or by others holding StreamerMutex.
+		uint32_t OpenedGeneration = 0;
+		const Sound* Source = nullptr;
+		bool ShouldLoop = false;
+		SDL_IOStream* File = nullptr;
+		SDL_AudioStream* Converter = nullptr;
+		int64_t DataStart = 0;
+		uint64_t DataBytes = 0;
+		uint64_t RemainingBytes = 0;
+		int SourceFrameBytes = 0;
+		bool IsFlushed = false;
+	};
+
+	static void MixCallback(void* UserData, SDL_AudioStream* Stream, int AdditionalAmount, int TotalAmount);
+	void Mix(int Frames);
+	void MixVoice(Voice& Voice, float* Output, int Frames);
+	void StopVoice(Voice& Voice);
+
+	void RunStreamer();
+	void UpdateStream(StreamSlot& Slot);
+	void OpenStream(StreamSlot& Slot);
+	void FillStream(StreamSlot& Slot);
+	void CloseStream(StreamSlot& Slot);
+
+	SDL_AudioStream* Device = nullptr;
+	SDL_AudioSpec MixSpec = { SDL_AUDIO_F32, MIX_CHANNELS, MIX_SAMPLE_RATE };
+	std::map<std::string, Sound> Sounds;
+
+	// Guarded by the device stream's lock, which SDL also holds while the callback runs.
+	std::array<Voice, MAX_VOICES> Voices;
+	uint64_t NextSerial = 1;
+	std::vector<float> MixBuffer;
+	std::atomic<float> ListenerX = 0.0f;
+	std::atomic<float> ListenerY = 0.0f;
+
+	std::array<StreamSlot, MAX_STREAMED_VOICES> Streams;
+	std::vector<uint8_t> ReadBuffer;
+	std::vector<float> DecodeBuffer;
+	std::thread Streamer;
+	// Held by the streamer for each pass over the slots; the callback never waits on it.
+	std::mutex StreamerMutex;
+	std::condition_variable StreamerWake;
+	bool IsStreamerStopping = false;
+};
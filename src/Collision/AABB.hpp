@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../Components/BoxColliderComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+
+struct AABB
+{
+	float MinX;
+	float MinY;
+	float MaxX;
+	float MaxY;
+
+	AABB(float MinX = 0.0f, float MinY = 0.0f, float MaxX = 0.0f, float MaxY = 0.0f)
+	{
+		this->MinX = MinX;
+		this->MinY = MinY;
+		this->MaxX = MaxX;
+		this->MaxY = MaxY;
+	}
+
+	static AABB FromCollider(const TransformComponent& Transform, const BoxColliderComponent& Collider)
+	{
+		const float X = Transform.Position.x + Collider.Offset.x;
+		const float Y = Transform.Position.y + Collider.Offset.y;
+		return AABB(X, Y, X + Collider.Width * Transform.Scale.x, Y + Collider.Height * Transform.Scale.y);
+	}
+
+	// Touching edges do not count as an overlap, same as the original per-pair check.
+	bool Overlaps(const AABB& Other) const
+	{
+		return MinX < Other.MaxX && MaxX > Other.MinX && MinY < Other.MaxY && MaxY > Other.MinY;
+	}
+};
@@ -0,0 +1,91 @@
+#include "AABBBatch.hpp"
+
+#if defined(__AVX2__)
+#define RLENGINE_OVERLAP_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RLENGINE_OVERLAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+uint64_t OverlapMaskScalar(const AABB& Query, const AABBBatch& Boxes, size_t Begin, size_t Count)
+{
+	uint64_t Mask = 0;
+	for (size_t i = 0; i < Count; ++i)
+	{
+		const size_t Box = Begin + i;
+		const bool Overlaps =
+			Query.MinX < Boxes.MaxX[Box] &&
+			Query.MaxX > Boxes.MinX[Box] &&
+			Query.MinY < Boxes.MaxY[Box] &&
+			Query.MaxY > Boxes.MinY[Box];
+		Mask |= static_cast<uint64_t>(Overlaps) << i;
+	}
+	return Mask;
+}
+
+uint64_t OverlapMask(const AABB& Query, const AABBBatch& Boxes, size_t Begin, size_t Count)
+{
+	uint64_t Mask = 0;
+	size_t i = 0;
+
+#if defined(RLENGINE_OVERLAP_AVX2)
+	const __m256 QueryMinX = _mm256_set1_ps(Query.MinX);
+	const __m256 QueryMinY = _mm256_set1_ps(Query.MinY);
+	const __m256 QueryMaxX = _mm256_set1_ps(Query.MaxX);
+	const __m256 QueryMaxY = _mm256_set1_ps(Query.MaxY);
+	for (; i + 8 <= Count; i += 8)
+	{
+		const size_t Box = Begin + i;
+		const __m256 OverlapX = _mm256_and_ps
+		(
+			_mm256_cmp_ps(QueryMinX, _mm256_loadu_ps(&Boxes.MaxX[Box]), _CMP_LT_OQ),
+			_mm256_cmp_ps(QueryMaxX, _mm256_loadu_ps(&Boxes.MinX[Box]), _CMP_GT_OQ)
+		);
+		const __m256 OverlapY = _mm256_and_ps
+		(
+			_mm256_cmp_ps(QueryMinY, _mm256_loadu_ps(&Boxes.MaxY[Box]), _CMP_LT_OQ),
+			_mm256_cmp_ps(QueryMaxY, _mm256_loadu_ps(&Boxes.MinY[Box]), _CMP_GT_OQ)
+		);
+		Mask |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_and_ps(OverlapX, OverlapY))) << i;
+	}
+#elif defined(RLENGINE_OVERLAP_SSE2)
+	const __m128 QueryMinX = _mm_set1_ps(Query.MinX);
+	const __m128 QueryMinY = _mm_set1_ps(Query.MinY);
+	const __m128 QueryMaxX = _mm_set1_ps(Query.MaxX);
+	const __m128 QueryMaxY = _mm_set1_ps(Query.MaxY);
+	for (; i + 4 <= Count; i += 4)
+	{
+		const size_t Box = Begin + i;
+		const __m128 OverlapX = _mm_and_ps
+		(
+			_mm_cmplt_ps(QueryMinX, _mm_loadu_ps(&Boxes.MaxX[Box])),
+			_mm_cmpgt_ps(QueryMaxX, _mm_loadu_ps(&Boxes.MinX[Box]))
+		);
+		const __m128 OverlapY = _mm_and_ps
+		(
+			_mm_cmplt_ps(QueryMinY, _mm_loadu_ps(&Boxes.MaxY[Box])),
+			_mm_cmpgt_ps(QueryMaxY, _mm_loadu_ps(&Boxes.MinY[Box]))
+		);
+		Mask |= static_cast<uint64_t>(_mm_movemask_ps(_mm_and_ps(OverlapX, OverlapY))) << i;
+	}
+#endif
+
+	// Remainder that does not fill a whole vector.
+	if (i < Count)
+	{
+		Mask |= OverlapMaskScalar(Query, Boxes, Begin + i, Count - i) << i;
+	}
+	return Mask;
+}
+
+const char* GetOverlapKernelName()
+{
+#if defined(RLENGINE_OVERLAP_AVX2)
+	return "AVX2";
+#elif defined(RLENGINE_OVERLAP_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
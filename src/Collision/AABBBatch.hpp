@@ -0,0 +1,56 @@
+#pragma once
+
+#include "AABB.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays copy of a list of boxes, laid out for the batched overlap kernels below.
+struct AABBBatch
+{
+	std::vector<float> MinX;
+	std::vector<float> MinY;
+	std::vector<float> MaxX;
+	std::vector<float> MaxY;
+
+	void Clear()
+	{
+		MinX.clear();
+		MinY.clear();
+		MaxX.clear();
+		MaxY.clear();
+	}
+
+	void Reserve(size_t Count)
+	{
+		MinX.reserve(Count);
+		MinY.reserve(Count);
+		MaxX.reserve(Count);
+		MaxY.reserve(Count);
+	}
+
+	void Push(const AABB& Bounds)
+	{
+		MinX.push_back(Bounds.MinX);
+		MinY.push_back(Bounds.MinY);
+		MaxX.push_back(Bounds.MaxX);
+		MaxY.push_back(Bounds.MaxY);
+	}
+
+	size_t Size() const
+	{
+		return MinX.size();
+	}
+};
+
+inline constexpr size_t MaxBatchSize = 64;
+
+// Tests Query against Boxes[Begin, Begin + Count) and returns one bit per box, bit i set when
+// Query overlaps Boxes[Begin + i]. Count must not exceed MaxBatchSize. Uses the same strict
+// comparisons as AABB::Overlaps, so every variant returns exactly the same mask.
+uint64_t OverlapMask(const AABB& Query, const AABBBatch& Boxes, size_t Begin, size_t Count);
+uint64_t OverlapMaskScalar(const AABB& Query, const AABBBatch& Boxes, size_t Begin, size_t Count);
+
+// Name of the instruction set OverlapMask was compiled for: "AVX2", "SSE2" or "Scalar".
+const char* GetOverlapKernelName();
@@ -0,0 +1,329 @@
+#include "AABBTree.hpp"
+
+#include <algorithm>
+
+static AABB Union(const AABB& A, const AABB& B)
+{
+	return AABB((std::min)(A.MinX, B.MinX), (std::min)(A.MinY, B.MinY), (std::max)(A.MaxX, B.MaxX), (std::max)(A.MaxY, B.MaxY));
+}
+
+static float Perimeter(const AABB& Bounds)
+{
+	return 2.0f * ((Bounds.MaxX - Bounds.MinX) + (Bounds.MaxY - Bounds.MinY));
+}
+
+static bool Contains(const AABB& Outer, const AABB& Inner)
+{
+	return Outer.MinX <= Inner.MinX && Outer.MinY <= Inner.MinY && Outer.MaxX >= Inner.MaxX && Outer.MaxY >= Inner.MaxY;
+}
+
+AABBTree::AABBTree(float Margin)
+	: Margin(Margin)
+{
+}
+
+AABB AABBTree::Fatten(const AABB& Bounds) const
+{
+	return AABB(Bounds.MinX - Margin, Bounds.MinY - Margin, Bounds.MaxX + Margin, Bounds.MaxY + Margin);
+}
+
+int32_t AABBTree::AllocateNode()
+{
+	if (FreeList == NullNode)
+	{
+		Nodes.emplace_back();
+		return static_cast<int32_t>(Nodes.size() - 1);
+	}
+
+	const int32_t Index = FreeList;
+	FreeList = Nodes[Index].Parent;
+	Nodes[Index] = Node();
+	return Index;
+}
+
+void AABBTree::FreeNode(int32_t Index)
+{
+	Nodes[Index].Parent = FreeList;
+	Nodes[Index].Height = -1;
+	FreeList = Index;
+}
+
+int32_t AABBTree::CreateProxy(const AABB& Bounds, uint64_t UserData, uint32_t Layers)
+{
+	const int32_t Proxy = AllocateNode();
+	Nodes[Proxy].Bounds = Bounds;
+	Nodes[Proxy].FatBounds = Fatten(Bounds);
+	Nodes[Proxy].UserData = UserData;
+	Nodes[Proxy].Layers = Layers;
+	Nodes[Proxy].Height = 0;
+	InsertLeaf(Proxy);
+	++ProxyCount;
+	return Proxy;
+}
+
+void AABBTree::DestroyProxy(int32_t Proxy)
+{
+	RemoveLeaf(Proxy);
+	FreeNode(Proxy);
+	--ProxyCount;
+}
+
+bool AABBTree::MoveProxy(int32_t Proxy, const AABB& Bounds)
+{
+	Nodes[Proxy].Bounds = Bounds;
+	if (Contains(Nodes[Proxy].FatBounds, Bounds))
+	{
+		return false;
+	}
+
+	RemoveLeaf(Proxy);
+	Nodes[Proxy].FatBounds = Fatten(Bounds);
+	InsertLeaf(Proxy);
+	return true;
+}
+
+void AABBTree::SetProxyLayers(int32_t Proxy, uint32_t Layers)
+{
+	if (Nodes[Proxy].Layers == Layers)
+	{
+		return;
+	}
+
+	Nodes[Proxy].Layers = Layers;
+	for (int32_t Index = Nodes[Proxy].Parent; Index != NullNode; Index = Nodes[Index].Parent)
+	{
+		Nodes[Index].Layers = Nodes[Nodes[Index].Left].Layers | Nodes[Nodes[Index].Right].Layers;
+	}
+}
+
+const AABB& AABBTree::GetBounds(int32_t Proxy) const
+{
+	return Nodes[Proxy].Bounds;
+}
+
+const AABB& AABBTree::GetFatBounds(int32_t Proxy) const
+{
+	return Nodes[Proxy].FatBounds;
+}
+
+uint64_t AABBTree::GetUserData(int32_t Proxy) const
+{
+	return Nodes[Proxy].UserData;
+}
+
+uint32_t AABBTree::GetLayers(int32_t Proxy) const
+{
+	return Nodes[Proxy].Layers;
+}
+
+int32_t AABBTree::GetProxyCount() const
+{
+	return ProxyCount;
+}
+
+int32_t AABBTree::GetHeight() const
+{
+	return Root == NullNode ? 0 : Nodes[Root].Height;
+}
+
+void AABBTree::Refit(int32_t Index)
+{
+	const Node& Left = Nodes[Nodes[Index].Left];
+	const Node& Right = Nodes[Nodes[Index].Right];
+	Nodes[Index].FatBounds = Union(Left.FatBounds, Right.FatBounds);
+	Nodes[Index].Height = 1 + (std::max)(Left.Height, Right.Height);
+	Nodes[Index].Layers = Left.Layers | Right.Layers;
+}
+
+void AABBTree::Clear()
+{
+	Nodes.clear();
+	Root = NullNode;
+	FreeList = NullNode;
+	ProxyCount = 0;
+}
+
+void AABBTree::InsertLeaf(int32_t Leaf)
+{
+	if (Root == NullNode)
+	{
+		Root = Leaf;
+		Nodes[Root].Parent = NullNode;
+		return;
+	}
+
+	// Walk down towards the sibling that grows the total perimeter the least.
+	const AABB LeafBounds = Nodes[Leaf].FatBounds;
+	int32_t Index = Root;
+	while (!Nodes[Index].IsLeaf())
+	{
+		const int32_t Left = Nodes[Index].Left;
+		const int32_t Right = Nodes[Index].Right;
+
+		const float CurrentPerimeter = Perimeter(Nodes[Index].FatBounds);
+		const float CombinedPerimeter = Perimeter(Union(Nodes[Index].FatBounds, LeafBounds));
+		const float CreateParentCost = 2.0f * CombinedPerimeter;
+		const float InheritanceCost = 2.0f * (CombinedPerimeter - CurrentPerimeter);
+
+		auto DescendCost = [this, &LeafBounds, InheritanceCost](int32_t Child)
+		{
+			const float UnionPerimeter = Perimeter(Union(LeafBounds, Nodes[Child].FatBounds));
+			return Nodes[Child].IsLeaf()
+				? UnionPerimeter + InheritanceCost
+				: UnionPerimeter - Perimeter(Nodes[Child].FatBounds) + InheritanceCost;
+		};
+
+		const float LeftCost = DescendCost(Left);
+		const float RightCost = DescendCost(Right);
+		if (CreateParentCost < LeftCost && CreateParentCost < RightCost)
+		{
+			break;
+		}
+
+		Index = LeftCost < RightCost ? Left : Right;
+	}
+
+	const int32_t Sibling = Index;
+	const int32_t OldParent = Nodes[Sibling].Parent;
+	const int32_t NewParent = AllocateNode();
+	Nodes[NewParent].Parent = OldParent;
+	Nodes[NewParent].Left = Sibling;
+	Nodes[NewParent].Right = Leaf;
+	Refit(NewParent);
+	Nodes[Sibling].Parent = NewParent;
+	Nodes[Leaf].Parent = NewParent;
+
+	if (OldParent == NullNode)
+	{
+		Root = NewParent;
+	}
+	else if (Nodes[OldParent].Left == Sibling)
+	{
+		Nodes[OldParent].Left = NewParent;
+	}
+	else
+	{
+		Nodes[OldParent].Right = NewParent;
+	}
+
+	// Refit the ancestors, rebalancing on the way up.
+	Index = Nodes[Leaf].Parent;
+	while (Index != NullNode)
+	{
+		Index = Balance(Index);
+		Refit(Index);
+		Index = Nodes[Index].Parent;
+	}
+}
+
+void AABBTree::RemoveLeaf(int32_t Leaf)
+{
+	if (Leaf == Root)
+	{
+		Root = NullNode;
+		return;
+	}
+
+	const int32_t Parent = Nodes[Leaf].Parent;
+	const int32_t GrandParent = Nodes[Parent].Parent;
+	const int32_t Sibling = Nodes[Parent].Left == Leaf ? Nodes[Parent].Right : Nodes[Parent].Left;
+
+	if (GrandParent == NullNode)
+	{
+		Root = Sibling;
+		Nodes[Sibling].Parent = NullNode;
+		FreeNode(Parent);
+		return;
+	}
+
+	if (Nodes[GrandParent].Left == Parent)
+	{
+		Nodes[GrandParent].Left = Sibling;
+	}
+	else
+	{
+		Nodes[GrandParent].Right = Sibling;
+	}
+	Nodes[Sibling].Parent = GrandParent;
+	FreeNode(Parent);
+
+	int32_t Index = GrandParent;
+	while (Index != NullNode)
+	{
+		Index = Balance(Index);
+		Refit(Index);
+		Index = Nodes[Index].Parent;
+	}
+}
+
+// Performs a left or right rotation when the subtree rooted at IndexA is imbalanced.
+// Returns the index of the new subtree root.
+int32_t AABBTree::Balance(int32_t IndexA)
+{
+	Node& A = Nodes[IndexA];
+	if (A.IsLeaf() || A.Height < 2)
+	{
+		return IndexA;
+	}
+
+	const int32_t IndexB = A.Left;
+	const int32_t IndexC = A.Right;
+	const int32_t HeightDifference = Nodes[IndexC].Height - Nodes[IndexB].Height;
+
+	// Promotes Upper (a child of A) one level, handing its shorter child down to A.
+	auto Rotate = [this, IndexA](int32_t IndexUpper, bool UpperWasRight)
+	{
+		Node& NodeA = Nodes[IndexA];
+		Node& Upper = Nodes[IndexUpper];
+		const int32_t IndexF = Upper.Left;
+		const int32_t IndexG = Upper.Right;
+
+		Upper.Left = IndexA;
+		Upper.Parent = NodeA.Parent;
+		NodeA.Parent = IndexUpper;
+
+		if (Upper.Parent == NullNode)
+		{
+			Root = IndexUpper;
+		}
+		else if (Nodes[Upper.Parent].Left == IndexA)
+		{
+			Nodes[Upper.Parent].Left = IndexUpper;
+		}
+		else
+		{
+			Nodes[Upper.Parent].Right = IndexUpper;
+		}
+
+		const bool KeepF = Nodes[IndexF].Height > Nodes[IndexG].Height;
+		const int32_t Kept = KeepF ? IndexF : IndexG;
+		const int32_t Given = KeepF ? IndexG : IndexF;
+
+		Upper.Right = Kept;
+		if (UpperWasRight)
+		{
+			NodeA.Right = Given;
+		}
+		else
+		{
+			NodeA.Left = Given;
+		}
+		Nodes[Given].Parent = IndexA;
+
+		Refit(IndexA);
+		Refit(IndexUpper);
+		return IndexUpper;
+	};
+
+	if (HeightDifference > 1)
+	{
+		return Rotate(IndexC, true);
+	}
+
+	if (HeightDifference < -1)
+	{
+		return Rotate(IndexB, false);
+	}
+
+	return IndexA;
+}
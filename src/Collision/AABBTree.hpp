@@ -0,0 +1,118 @@
+#pragma once
+
+#include "AABB.hpp"
+#include "CollisionLayers.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Incrementally updated bounding volume hierarchy. Leaves store the tight bounds of a
+// collider plus a copy fattened by Margin, so small movements do not touch the tree.
+// Every node also keeps the union of the collision layers below it, which lets queries
+// skip whole subtrees that cannot interact with the querying collider.
+class AABBTree
+{
+public:
+	static constexpr int32_t NullNode = -1;
+	static constexpr float DefaultMargin = 8.0f;
+
+	explicit AABBTree(float Margin = DefaultMargin);
+
+	int32_t CreateProxy(const AABB& Bounds, uint64_t UserData, uint32_t Layers = CollisionLayer::All);
+	void DestroyProxy(int32_t Proxy);
+
+	// Updates the tight bounds of a proxy. Returns true when the proxy left its fat bounds
+	// and had to be reinserted.
+	bool MoveProxy(int32_t Proxy, const AABB& Bounds);
+	void SetProxyLayers(int32_t Proxy, uint32_t Layers);
+
+	const AABB& GetBounds(int32_t Proxy) const;
+	const AABB& GetFatBounds(int32_t Proxy) const;
+	uint64_t GetUserData(int32_t Proxy) const;
+	uint32_t GetLayers(int32_t Proxy) const;
+	int32_t GetProxyCount() const;
+	int32_t GetHeight() const;
+	void Clear();
+
+	// Calls OnOverlap(Proxy) for every leaf on one of the Mask layers whose fat bounds overlap
+	// Bounds. Safe to call concurrently from several threads as long as nobody modifies the tree.
+	template <typename Callback>
+	void Query(const AABB& Bounds, uint32_t Mask, Callback&& OnOverlap) const;
+
+private:
+	// Enough for any balanced tree a level realistically holds; deeper trees query from the heap.
+	static constexpr int32_t QueryStackSize = 64;
+
+	struct Node
+	{
+		AABB FatBounds;
+		AABB Bounds;
+		uint64_t UserData = 0;
+		uint32_t Layers = CollisionLayer::All;
+		int32_t Parent = NullNode; // Next free node while the node sits in the free list.
+		int32_t Left = NullNode;
+		int32_t Right = NullNode;
+		int32_t Height = -1;
+
+		bool IsLeaf() const
+		{
+			return Left == NullNode;
+		}
+	};
+
+	int32_t AllocateNode();
+	void FreeNode(int32_t Index);
+	void InsertLeaf(int32_t Leaf);
+	void RemoveLeaf(int32_t Leaf);
+	int32_t Balance(int32_t Index);
+	void Refit(int32_t Index);
+	AABB Fatten(const AABB& Bounds) const;
+
+	std::vector<Node> Nodes;
+	int32_t Root = NullNode;
+	int32_t FreeList = NullNode;
+	int32_t ProxyCount = 0;
+	float Margin;
+};
+
+template <typename Callback>
+void AABBTree::Query(const AABB& Bounds, uint32_t Mask, Callback&& OnOverlap) const
+{
+	if (Root == NullNode)
+	{
+		return;
+	}
+
+	// A depth-first walk holds at most one pending sibling per level, so the root's height bounds
+	// the stack and no subtree is ever skipped.
+	int32_t FixedStack[QueryStackSize];
+	std::vector<int32_t> HeapStack;
+	int32_t* Stack = FixedStack;
+	if (Nodes[Root].Height + 2 > QueryStackSize)
+	{
+		HeapStack.resize(static_cast<size_t>(Nodes[Root].Height) + 2);
+		Stack = HeapStack.data();
+	}
+
+	int32_t StackSize = 0;
+	Stack[StackSize++] = Root;
+
+	while (StackSize > 0)
+	{
+		const Node& Current = Nodes[Stack[--StackSize]];
+		if ((Current.Layers & Mask) == 0 || !Current.FatBounds.Overlaps(Bounds))
+		{
+			continue;
+		}
+
+		if (Current.IsLeaf())
+		{
+			OnOverlap(static_cast<int32_t>(&Current - Nodes.data()));
+		}
+		else
+		{
+			Stack[StackSize++] = Current.Left;
+			Stack[StackSize++] = Current.Right;
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+// One bit per gameplay tag. Colliders without any gameplay tag stay on the Default layer.
+namespace CollisionLayer
+{
+	inline constexpr uint32_t None = 0;
+	inline constexpr uint32_t Default = 1u << 0;
+	inline constexpr uint32_t Player = 1u << 1;
+	inline constexpr uint32_t Enemies = 1u << 2;
+	inline constexpr uint32_t Obstacles = 1u << 3;
+	inline constexpr uint32_t Projectiles = 1u << 4;
+	inline constexpr uint32_t Tiles = 1u << 5;
+	inline constexpr uint32_t Ui = 1u << 6;
+	inline constexpr uint32_t All = ~0u;
+}
+
+// Symmetric layer-vs-layer interaction table. Two colliders are only paired by the
+// broadphase when one of the layers of A interacts with one of the layers of B.
+class CollisionLayerMatrix
+{
+public:
+	CollisionLayerMatrix()
+	{
+		SetInteraction(CollisionLayer::Enemies, CollisionLayer::Obstacles, true);
+		SetInteraction(CollisionLayer::Projectiles, CollisionLayer::Player, true);
+		SetInteraction(CollisionLayer::Projectiles, CollisionLayer::Enemies, true);
+	}
+
+	void Clear()
+	{
+		Rows.fill(CollisionLayer::None);
+	}
+
+	// LayerA and LayerB must be single layer bits.
+	void SetInteraction(uint32_t LayerA, uint32_t LayerB, bool Interacts)
+	{
+		if (LayerA == CollisionLayer::None || LayerB == CollisionLayer::None)
+		{
+			return;
+		}
+
+		uint32_t& RowA = Rows[std::countr_zero(LayerA)];
+		uint32_t& RowB = Rows[std::countr_zero(LayerB)];
+		RowA = Interacts ? RowA | LayerB : RowA & ~LayerB;
+		RowB = Interacts ? RowB | LayerA : RowB & ~LayerA;
+	}
+
+	// Union of every layer that interacts with at least one of Layers.
+	uint32_t GetMask(uint32_t Layers) const
+	{
+		uint32_t Mask = CollisionLayer::None;
+		while (Layers != 0)
+		{
+			Mask |= Rows[std::countr_zero(Layers)];
+			Layers &= Layers - 1;
+		}
+		return Mask;
+	}
+
+	bool ShouldCollide(uint32_t LayersA, uint32_t LayersB) const
+	{
+		return (GetMask(LayersA) & LayersB) != 0;
+	}
+
+private:
+	std::array<uint32_t, 32> Rows{};
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+enum class ContactEvent : uint8_t
+{
+	Begin,
+	Persist,
+	End
+};
+
+// Entity ids are flecs::entity_t; this header stays free of flecs so benchmarks can use it.
+struct CollisionCandidate
+{
+	uint64_t A;
+	uint64_t B;
+	uint32_t LayersA;
+	uint32_t LayersB;
+};
+
+// Classifies this frame's overlapping pairs against last frame's. Both lists are sorted by (A, B)
+// with A < B, so a single merge pass calls OnContact(Candidate, Event) for every contact.
+template <typename Callback>
+void MergeContacts(const std::vector<CollisionCandidate>& Current, const std::vector<CollisionCandidate>& Previous, Callback&& OnContact)
+{
+	size_t CurrentIndex = 0;
+	size_t PreviousIndex = 0;
+	while (CurrentIndex < Current.size() || PreviousIndex < Previous.size())
+	{
+		if (PreviousIndex == Previous.size())
+		{
+			OnContact(Current[CurrentIndex++], ContactEvent::Begin);
+			continue;
+		}
+		if (CurrentIndex == Current.size())
+		{
+			OnContact(Previous[PreviousIndex++], ContactEvent::End);
+			continue;
+		}
+
+		const CollisionCandidate& New = Current[CurrentIndex];
+		const CollisionCandidate& Old = Previous[PreviousIndex];
+		if (New.A == Old.A && New.B == Old.B)
+		{
+			OnContact(New, ContactEvent::Persist);
+			++CurrentIndex;
+			++PreviousIndex;
+		}
+		else if (New.A < Old.A || (New.A == Old.A && New.B < Old.B))
+		{
+			OnContact(New, ContactEvent::Begin);
+			++CurrentIndex;
+		}
+		else
+		{
+			OnContact(Old, ContactEvent::End);
+			++PreviousIndex;
+		}
+	}
+}
+
+// Moves every contact involving one of SortedIDs from Contacts to OutErased, keeping Contacts sorted.
+// Used when an entity id is recycled, so its next contact with the same partner begins again.
+inline void EraseContactsOf(std::vector<CollisionCandidate>& Contacts, const std::vector<uint64_t>& SortedIDs, std::vector<CollisionCandidate>& OutErased)
+{
+	OutErased.clear();
+	const auto IsErased = [&SortedIDs](const CollisionCandidate& Contact)
+	{
+		return std::binary_search(SortedIDs.begin(), SortedIDs.end(), Contact.A) || std::binary_search(SortedIDs.begin(), SortedIDs.end(), Contact.B);
+	};
+
+	size_t Kept = 0;
+	for (const CollisionCandidate& Contact : Contacts)
+	{
+		if (IsErased(Contact))
+		{
+			OutErased.push_back(Contact);
+		}
+		else
+		{
+			Contacts[Kept++] = Contact;
+		}
+	}
+	Contacts.resize(Kept);
+}
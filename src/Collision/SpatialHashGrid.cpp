@@ -0,0 +1,115 @@
+#include "SpatialHashGrid.hpp"
+
+SpatialHashGrid::SpatialHashGrid(float CellSize)
+{
+	SetCellSize(CellSize);
+}
+
+void SpatialHashGrid::SetCellSize(float CellSize)
+{
+	this->CellSize = CellSize > 0.0f ? CellSize : DefaultCellSize;
+	InverseCellSize = 1.0f / this->CellSize;
+}
+
+float SpatialHashGrid::GetCellSize() const
+{
+	return CellSize;
+}
+
+void SpatialHashGrid::Build(const std::vector<AABB>& Bounds, const std::vector<uint32_t>& Layers)
+{
+	Entries.clear();
+	for (uint32_t Index = 0; Index < Bounds.size(); ++Index)
+	{
+		const AABB& Box = Bounds[Index];
+		const int32_t FirstCellX = ToCell(Box.MinX);
+		const int32_t FirstCellY = ToCell(Box.MinY);
+		const int32_t LastCellX = ToCell(Box.MaxX);
+		const int32_t LastCellY = ToCell(Box.MaxY);
+
+		for (int32_t CellY = FirstCellY; CellY <= LastCellY; ++CellY)
+		{
+			for (int32_t CellX = FirstCellX; CellX <= LastCellX; ++CellX)
+			{
+				Entries.push_back({ MakeCellKey(CellX, CellY), Index });
+			}
+		}
+	}
+
+	// Sorting by (cell, index) turns every cell into a contiguous run and keeps the output deterministic.
+	std::sort(Entries.begin(), Entries.end(), [](const CellEntry& A, const CellEntry& B)
+	{
+		return A.CellKey != B.CellKey ? A.CellKey < B.CellKey : A.Index < B.Index;
+	});
+
+	EntryBounds.Clear();
+	EntryBounds.Reserve(Entries.size());
+	EntryLayers.clear();
+	EntryLayers.reserve(Entries.size());
+	for (const CellEntry& Entry : Entries)
+	{
+		EntryBounds.Push(Bounds[Entry.Index]);
+		EntryLayers.push_back(Layers.empty() ? CollisionLayer::All : Layers[Entry.Index]);
+	}
+}
+
+void SpatialHashGrid::FindPairs(const std::vector<AABB>& Bounds, std::vector<std::pair<uint32_t, uint32_t>>& OutPairs) const
+{
+	FindPairs(Bounds, {}, OutPairs);
+}
+
+void SpatialHashGrid::FindPairs(const std::vector<AABB>& Bounds, const std::vector<uint32_t>& Masks, std::vector<std::pair<uint32_t, uint32_t>>& OutPairs) const
+{
+
+	size_t RunBegin = 0;
+	while (RunBegin < Entries.size())
+	{
+		const uint64_t CellKey = Entries[RunBegin].CellKey;
+		size_t RunEnd = RunBegin + 1;
+		while (RunEnd < Entries.size() && Entries[RunEnd].CellKey == CellKey)
+		{
+			++RunEnd;
+		}
+
+		for (size_t A = RunBegin; A < RunEnd; ++A)
+		{
+			const AABB& BoxA = Bounds[Entries[A].Index];
+			const uint32_t MaskA = Masks.empty() ? CollisionLayer::All : Masks[Entries[A].Index];
+			for (size_t BatchBegin = A + 1; BatchBegin < RunEnd; BatchBegin += MaxBatchSize)
+			{
+				const size_t BatchCount = (std::min)(RunEnd - BatchBegin, MaxBatchSize);
+				const uint64_t Interacting = LayerMask(MaskA, BatchBegin, BatchCount);
+				if (Interacting == 0)
+				{
+					continue;
+				}
+
+				uint64_t Hits = OverlapMask(BoxA, EntryBounds, BatchBegin, BatchCount) & Interacting;
+				while (Hits != 0)
+				{
+					const size_t B = BatchBegin + static_cast<size_t>(std::countr_zero(Hits));
+					Hits &= Hits - 1;
+
+					// A pair spanning several shared cells is only reported by the cell holding the
+					// top-left corner of the intersection.
+					const AABB& BoxB = Bounds[Entries[B].Index];
+					const int32_t OwnerCellX = ToCell((std::max)(BoxA.MinX, BoxB.MinX));
+					const int32_t OwnerCellY = ToCell((std::max)(BoxA.MinY, BoxB.MinY));
+					if (MakeCellKey(OwnerCellX, OwnerCellY) == CellKey)
+					{
+						OutPairs.emplace_back(Entries[A].Index, Entries[B].Index);
+					}
+				}
+			}
+		}
+
+		RunBegin = RunEnd;
+	}
+}
+
+void SpatialHashGrid::Clear()
+{
+	Entries.clear();
+	EntryBounds.Clear();
+	EntryLayers.clear();
+}
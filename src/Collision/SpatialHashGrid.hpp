@@ -0,0 +1,129 @@
+#pragma once
+
+#include "AABB.hpp"
+#include "AABBBatch.hpp"
+#include "CollisionLayers.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Uniform grid broadphase. The grid is rebuilt from a flat array of bounds and reports
+// every overlapping pair exactly once, as (lower index, higher index). When per-collider
+// layers and masks are given, pairs that do not interact are dropped before the overlap test.
+// Each cell's boxes are kept in a structure-of-arrays copy so they can be tested in SIMD batches.
+class SpatialHashGrid
+{
+public:
+	static constexpr float DefaultCellSize = 64.0f;
+
+	explicit SpatialHashGrid(float CellSize = DefaultCellSize);
+
+	void SetCellSize(float CellSize);
+	float GetCellSize() const;
+
+	// Layers, when given, holds the collision layers of each box; without it every box is on all layers.
+	void Build(const std::vector<AABB>& Bounds, const std::vector<uint32_t>& Layers = {});
+	void FindPairs(const std::vector<AABB>& Bounds, std::vector<std::pair<uint32_t, uint32_t>>& OutPairs) const;
+	void FindPairs(const std::vector<AABB>& Bounds, const std::vector<uint32_t>& Masks, std::vector<std::pair<uint32_t, uint32_t>>& OutPairs) const;
+	void Clear();
+
+	// Calls OnOverlap(Index) once for every collider on one of the Mask layers whose bounds
+	// overlap QueryBounds. Bounds must be the array the grid was built from.
+	// Safe to call concurrently from several threads once Build() has returned.
+	template <typename Callback>
+	void Query(const AABB& QueryBounds, const std::vector<AABB>& Bounds, uint32_t Mask, Callback&& OnOverlap) const;
+
+private:
+	struct CellEntry
+	{
+		uint64_t CellKey;
+		uint32_t Index;
+	};
+
+	int32_t ToCell(float Coordinate) const
+	{
+		return static_cast<int32_t>(std::floor(Coordinate * InverseCellSize));
+	}
+
+	static uint64_t MakeCellKey(int32_t CellX, int32_t CellY)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(CellX)) << 32) | static_cast<uint32_t>(CellY);
+	}
+
+	// One bit per entry in [Begin, Begin + Count) that is on one of the Mask layers. Much cheaper
+	// than the bounds test, so it runs first and a batch with no interacting layers is skipped.
+	uint64_t LayerMask(uint32_t Mask, size_t Begin, size_t Count) const
+	{
+		uint64_t Result = 0;
+		for (size_t i = 0; i < Count; ++i)
+		{
+			Result |= static_cast<uint64_t>((EntryLayers[Begin + i] & Mask) != 0) << i;
+		}
+		return Result;
+	}
+
+	float CellSize;
+	float InverseCellSize;
+	std::vector<CellEntry> Entries;
+	// Bounds and layers of Entries[i] at position i, so every cell run is contiguous in memory.
+	AABBBatch EntryBounds;
+	std::vector<uint32_t> EntryLayers;
+};
+
+template <typename Callback>
+void SpatialHashGrid::Query(const AABB& QueryBounds, const std::vector<AABB>& Bounds, uint32_t Mask, Callback&& OnOverlap) const
+{
+	const int32_t FirstCellX = ToCell(QueryBounds.MinX);
+	const int32_t FirstCellY = ToCell(QueryBounds.MinY);
+	const int32_t LastCellX = ToCell(QueryBounds.MaxX);
+	const int32_t LastCellY = ToCell(QueryBounds.MaxY);
+
+	for (int32_t CellY = FirstCellY; CellY <= LastCellY; ++CellY)
+	{
+		for (int32_t CellX = FirstCellX; CellX <= LastCellX; ++CellX)
+		{
+			const uint64_t CellKey = MakeCellKey(CellX, CellY);
+			auto Entry = std::lower_bound(Entries.begin(), Entries.end(), CellKey, [](const CellEntry& Current, uint64_t Key)
+			{
+				return Current.CellKey < Key;
+			});
+
+			const size_t RunBegin = static_cast<size_t>(Entry - Entries.begin());
+			size_t RunEnd = RunBegin;
+			while (RunEnd < Entries.size() && Entries[RunEnd].CellKey == CellKey)
+			{
+				++RunEnd;
+			}
+
+			for (size_t BatchBegin = RunBegin; BatchBegin < RunEnd; BatchBegin += MaxBatchSize)
+			{
+				const size_t BatchCount = (std::min)(RunEnd - BatchBegin, MaxBatchSize);
+				const uint64_t Interacting = LayerMask(Mask, BatchBegin, BatchCount);
+				if (Interacting == 0)
+				{
+					continue;
+				}
+
+				uint64_t Hits = OverlapMask(QueryBounds, EntryBounds, BatchBegin, BatchCount) & Interacting;
+				while (Hits != 0)
+				{
+					const size_t Slot = BatchBegin + static_cast<size_t>(std::countr_zero(Hits));
+					Hits &= Hits - 1;
+
+					const uint32_t Index = Entries[Slot].Index;
+					// Same ownership rule as FindPairs, so a collider spanning several cells is reported once.
+					const int32_t OwnerCellX = ToCell((std::max)(QueryBounds.MinX, Bounds[Index].MinX));
+					const int32_t OwnerCellY = ToCell((std::max)(QueryBounds.MinY, Bounds[Index].MinY));
+					if (OwnerCellX == CellX && OwnerCellY == CellY)
+					{
+						OnOverlap(Index);
+					}
+				}
+			}
+		}
+	}
+}
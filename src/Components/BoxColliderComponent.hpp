@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../Collision/CollisionLayers.hpp"
+
 #include <glm/glm.hpp>
 
 struct BoxColliderComponent
@@ -7,11 +9,13 @@ struct BoxColliderComponent
 	uint16_t Width;
 	uint16_t Height;
 	glm::vec2 Offset;
+	uint32_t Layers;
 
-	BoxColliderComponent(uint16_t Width = 0, uint16_t Height = 0, glm::vec2 Offset = { 0, 0 })
+	BoxColliderComponent(uint16_t Width = 0, uint16_t Height = 0, glm::vec2 Offset = { 0, 0 }, uint32_t Layers = CollisionLayer::Default)
 	{
 		this->Width = Width;
 		this->Height = Height;
 		this->Offset = Offset;
+		this->Layers = Layers;
 	}
 };
\ No newline at end of file
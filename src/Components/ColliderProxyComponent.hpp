@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+// Handle of the broadphase tree leaf that mirrors an entity's box collider. Maintained by
+// the collision observers, never set by gameplay code.
+struct ColliderProxyComponent
+{
+	int32_t Proxy;
+	bool IsStatic;
+
+	ColliderProxyComponent(int32_t Proxy = -1, bool IsStatic = true)
+	{
+		this->Proxy = Proxy;
+		this->IsStatic = IsStatic;
+	}
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <sol/sol.hpp>
+
+struct CollisionScriptComponent
+{
+	sol::function OnEnter;
+	sol::function OnExit;
+	CollisionScriptComponent(sol::function OnEnter = sol::lua_nil, sol::function OnExit = sol::lua_nil)
+	{
+		this->OnEnter = OnEnter;
+		this->OnExit = OnExit;
+	}
+};
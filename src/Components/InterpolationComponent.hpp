@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Position at the start of the last simulation tick. Rendering blends from here to the current
+// TransformComponent position, so moving bodies stay smooth when ticks and frames do not line up.
+struct InterpolationComponent
+{
+	glm::vec2 PreviousPosition;
+
+	InterpolationComponent(glm::vec2 PreviousPosition = glm::vec2(0, 0))
+	{
+		this->PreviousPosition = PreviousPosition;
+	}
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../Particles/ParticleEffect.hpp"
+
+#include <cstdint>
+
+// One-off bursts tied to gameplay events: an explosion when the entity is marked for destruction
+// and a muzzle flash whenever its projectile emitter fires.
+struct ParticleBurstComponent
+{
+	ParticleEffect DestroyEffect;
+	uint16_t DestroyCount;
+	ParticleEffect FireEffect;
+	uint16_t FireCount;
+
+	ParticleBurstComponent
+	(
+		const ParticleEffect& DestroyEffect = ParticleEffect(),
+		uint16_t DestroyCount = 0,
+		const ParticleEffect& FireEffect = ParticleEffect(),
+		uint16_t FireCount = 0
+	)
+	{
+		this->DestroyEffect = DestroyEffect;
+		this->DestroyCount = DestroyCount;
+		this->FireEffect = FireEffect;
+		this->FireCount = FireCount;
+	}
+};
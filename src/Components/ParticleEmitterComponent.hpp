@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../Particles/ParticleEffect.hpp"
+
+// Emits particles continuously while the entity exists, such as smoke trailing a damaged tank.
+struct ParticleEmitterComponent
+{
+	ParticleEffect Effect;
+	float EmissionRate;
+	// Fractional particles carried over between ticks, so low rates still emit on average.
+	float PendingParticles;
+
+	ParticleEmitterComponent(const ParticleEffect& Effect = ParticleEffect(), float EmissionRate = 0.0f)
+	{
+		this->Effect = Effect;
+		this->EmissionRate = EmissionRate;
+		this->PendingParticles = 0.0f;
+	}
+};
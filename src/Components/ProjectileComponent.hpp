@@ -1,6 +1,5 @@
 #pragma once
 
-#include <SDL3/SDL.h>
 #include <stdint.h>
 
 struct ProjectileComponent
@@ -8,13 +7,13 @@ struct ProjectileComponent
 	bool IsFriendly;
 	uint8_t HitPercentDamage;
 	uint16_t Duration;
-	uint64_t StartTime;
+	float AgeMilliseconds;
 
 	ProjectileComponent(bool IsFriendly = false, uint8_t HitPercentDamage = 0, uint16_t Duration = 0)
 	{
 		this->IsFriendly = IsFriendly;
 		this->HitPercentDamage = HitPercentDamage;
 		this->Duration = Duration;
-		this->StartTime = SDL_GetTicks();
+		this->AgeMilliseconds = 0.0f;
 	}
 };
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <SDL3/SDL.h>
+#include <stdint.h>
 
 struct ProjectileEmitterComponent
 {
@@ -10,7 +10,8 @@ struct ProjectileEmitterComponent
 	uint16_t ProjectileDuration;
 	uint8_t HitPercentDamage;
 	bool IsFriendly;
-	uint64_t LastEmissionTime;
+	// Simulated time since the last emission, so the rate follows the tick rate rather than the wall clock.
+	float MillisecondsSinceEmission;
 
 	ProjectileEmitterComponent
 	(
@@ -26,6 +27,6 @@ struct ProjectileEmitterComponent
 		this->ProjectileDuration = ProjectileDuration;
 		this->HitPercentDamage = HitPercentDamage;
 		this->IsFriendly = IsFriendly;
-		this->LastEmissionTime = SDL_GetTicks();
+		this->MillisecondsSinceEmission = 0.0f;
 	}
 };
\ No newline at end of file
@@ -1,12 +1,13 @@
 #pragma once
 
+#include "../AssetManager/TextureHandle.hpp"
+
 #include <stdint.h>
-#include <string>
 #include <SDL3/SDL.h>
 
 struct SpriteComponent
 {
-	std::string AssetID;
+	TextureHandle Texture; // Resolved with AssetManager::GetTextureHandle when the sprite is created.
 	uint16_t Width;
 	uint16_t Height;
 	uint8_t ZIndex; // Use layers instead of ZIndex.
@@ -14,9 +15,9 @@ struct SpriteComponent
 	bool IsFixed;
 	SDL_FRect SrcRect;
 
-	SpriteComponent(std::string AssetID = "", uint16_t Width = 0, uint16_t Height = 0, uint8_t ZIndex = 0, bool IsFixed = false, uint16_t SrcRectX = 0, uint16_t SrcRectY = 0)
+	SpriteComponent(TextureHandle Texture = TextureHandle(), uint16_t Width = 0, uint16_t Height = 0, uint8_t ZIndex = 0, bool IsFixed = false, uint16_t SrcRectX = 0, uint16_t SrcRectY = 0)
 	{
-		this->AssetID = AssetID;
+		this->Texture = Texture;
 		this->Width = Width;
 		this->Height = Height;
 		this->ZIndex = ZIndex;
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+// Handle of the visibility tree leaf that mirrors an entity's sprite, and the z-index of the tree
+// it lives in. Maintained by the render observers, never set by gameplay code.
+struct SpriteProxyComponent
+{
+	int32_t Proxy;
+	uint8_t ZIndex;
+
+	SpriteProxyComponent(int32_t Proxy = -1, uint8_t ZIndex = 0)
+	{
+		this->Proxy = Proxy;
+		this->ZIndex = ZIndex;
+	}
+};
@@ -1,5 +1,8 @@
 #include "FlecsSystems.hpp"
+#include "../Collision/AABB.hpp"
 #include "../Components/BoxColliderComponent.hpp"
+#include "../Components/ColliderProxyComponent.hpp"
+#include "../Components/CollisionScriptComponent.hpp"
 #include "../Components/HealthComponent.hpp"
 #include "../Components/ProjectileComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
@@ -10,7 +13,6 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <iterator>
 #include <vector>
 
 static bool IsAlive(flecs::world& World, flecs::entity Entity)
@@ -18,11 +20,6 @@ static bool IsAlive(flecs::world& World, flecs::entity Entity)
 	return Entity.id() != 0 && World.is_alive(Entity.id());
 }
 
-static bool CheckAABBCollision(double AX, double AY, double AW, double AH, double BX, double BY, double BW, double BH)
-{
-	return AX < BX + BW && AX + AW > BX && AY < BY + BH && AY + AH > BY;
-}
-
 static void HandleProjectileHitsHealthTarget(flecs::entity ProjectileEntity, flecs::entity TargetEntity, bool TargetIsPlayer)
 {
 	if (!ProjectileEntity.has<ProjectileComponent>() || !TargetEntity.has<HealthComponent>())
@@ -75,46 +72,281 @@ static void BounceEnemyOffObstacle(flecs::entity Enemy)
 	Enemy.modified<SpriteComponent>();
 }
 
-static void CollisionDetectionSystemTask(flecs::iter& Iter, size_t)
+static AABBTree& GetProxyTree(CollisionState& Collision, bool IsStatic)
+{
+	return IsStatic ? Collision.StaticTree : Collision.DynamicTree;
+}
+
+static void SyncColliderProxy(flecs::entity Entity, const AABB& Bounds, uint32_t Layers, bool IsStatic)
+{
+	auto World = Entity.world();
+	auto& Collision = World.get_mut<CollisionState>();
+
+	if (!Entity.has<ColliderProxyComponent>())
+	{
+		const int32_t Proxy = GetProxyTree(Collision, IsStatic).CreateProxy(Bounds, Entity.id(), Layers);
+		Entity.set<ColliderProxyComponent>(ColliderProxyComponent(Proxy, IsStatic));
+		return;
+	}
+
+	auto& Proxy = Entity.get_mut<ColliderProxyComponent>();
+	if (Proxy.Proxy != AABBTree::NullNode && Proxy.IsStatic == IsStatic)
+	{
+		GetProxyTree(Collision, IsStatic).MoveProxy(Proxy.Proxy, Bounds);
+		GetProxyTree(Collision, IsStatic).SetProxyLayers(Proxy.Proxy, Layers);
+		return;
+	}
+
+	if (Proxy.Proxy != AABBTree::NullNode)
+	{
+		GetProxyTree(Collision, Proxy.IsStatic).DestroyProxy(Proxy.Proxy);
+	}
+
+	Proxy.Proxy = GetProxyTree(Collision, IsStatic).CreateProxy(Bounds, Entity.id(), Layers);
+	Proxy.IsStatic = IsStatic;
+}
+
+static void ColliderProxySetObserverTask(flecs::iter& Iter, size_t Row, const TransformComponent& Transform, const BoxColliderComponent& Collider)
+{
+	flecs::entity Entity = Iter.entity(Row);
+	SyncColliderProxy(Entity, AABB::FromCollider(Transform, Collider), Collider.Layers, !Entity.has<RigidBodyComponent>());
+}
+
+static void ColliderProxyRemoveObserverTask(flecs::iter& Iter, size_t Row, const TransformComponent&, const BoxColliderComponent&)
+{
+	flecs::entity Entity = Iter.entity(Row);
+	if (!Entity.has<ColliderProxyComponent>())
+	{
+		return;
+	}
+
+	auto& Proxy = Entity.get_mut<ColliderProxyComponent>();
+	if (Proxy.Proxy != AABBTree::NullNode)
+	{
+		auto World = Iter.world();
+		GetProxyTree(World.get_mut<CollisionState>(), Proxy.IsStatic).DestroyProxy(Proxy.Proxy);
+		Proxy.Proxy = AABBTree::NullNode;
+	}
+}
+
+// Moves an existing proxy to the dynamic tree when a rigid body is added. When one is removed the
+// dynamic proxy is destroyed and the entity queued for a static one, since the body may be going away
+// along with the rest of the entity.
+static void ColliderProxyBodyObserverTask(flecs::iter& Iter, size_t Row, const RigidBodyComponent&)
+{
+	flecs::entity Entity = Iter.entity(Row);
+	if (!Entity.has<ColliderProxyComponent>() || Entity.get<ColliderProxyComponent>().Proxy == AABBTree::NullNode)
+	{
+		return;
+	}
+
+	if (Iter.event().id() == flecs::OnRemove)
+	{
+		auto World = Iter.world();
+		auto& Collision = World.get_mut<CollisionState>();
+		auto& Proxy = Entity.get_mut<ColliderProxyComponent>();
+		GetProxyTree(Collision, Proxy.IsStatic).DestroyProxy(Proxy.Proxy);
+		Proxy.Proxy = AABBTree::NullNode;
+		Collision.PendingStaticProxies.push_back(Entity.id());
+		return;
+	}
+
+	const auto& Collider = Entity.get<BoxColliderComponent>();
+	SyncColliderProxy(Entity, AABB::FromCollider(Entity.get<TransformComponent>(), Collider), Collider.Layers, false);
+}
+
+// Reinserts the colliders that lost their rigid body and still exist; deleted ones were already
+// taken out of the tree by the body observer.
+static void CreatePendingStaticProxies(flecs::world& World, CollisionState& Collision)
+{
+	for (const flecs::entity_t EntityID : Collision.PendingStaticProxies)
+	{
+		const flecs::entity Entity(World, EntityID);
+		if (!IsAlive(World, Entity) || !Entity.enabled() || !Entity.has<TransformComponent>() || !Entity.has<BoxColliderComponent>() || !Entity.has<ColliderProxyComponent>())
+		{
+			continue;
+		}
+		if (Entity.get<ColliderProxyComponent>().Proxy != AABBTree::NullNode)
+		{
+			continue;
+		}
+
+		const auto& Collider = Entity.get<BoxColliderComponent>();
+		SyncColliderProxy(Entity, AABB::FromCollider(Entity.get<TransformComponent>(), Collider), Collider.Layers, !Entity.has<RigidBodyComponent>());
+	}
+	Collision.PendingStaticProxies.clear();
+}
+
+static void RefitDynamicTree(flecs::world& World, CollisionState& Collision)
+{
+	// Systems write transforms in place without emitting OnSet, so moving proxies are refit here.
+	// Thanks to the fattened bounds most of these updates do not touch the tree structure.
+	World.each([&Collision](const TransformComponent& Transform, const BoxColliderComponent& Collider, const RigidBodyComponent&, const ColliderProxyComponent& Proxy)
+	{
+		if (!Proxy.IsStatic && Proxy.Proxy != AABBTree::NullNode)
+		{
+			Collision.DynamicTree.MoveProxy(Proxy.Proxy, AABB::FromCollider(Transform, Collider));
+		}
+	});
+}
+
+static void RebuildSpatialHash(flecs::world& World, CollisionState& Collision)
+{
+	Collision.ColliderIDs.clear();
+	Collision.ColliderBounds.clear();
+	Collision.ColliderIsStatic.clear();
+	Collision.ColliderLayers.clear();
+
+	World.each([&Collision](flecs::entity Entity, const TransformComponent& Transform, const BoxColliderComponent& Collider)
+	{
+		Collision.ColliderIDs.push_back(Entity.id());
+		Collision.ColliderBounds.push_back(AABB::FromCollider(Transform, Collider));
+		Collision.ColliderIsStatic.push_back(!Entity.has<RigidBodyComponent>());
+		Collision.ColliderLayers.push_back(Collider.Layers);
+	});
+
+	Collision.Grid.Build(Collision.ColliderBounds, Collision.ColliderLayers);
+}
+
+// Candidates are stored with the lower entity id first so the merged list can be sorted into
+// the same order no matter how the bodies were split across worker threads.
+static void PushCandidate(std::vector<CollisionCandidate>& Candidates, flecs::entity_t A, uint32_t LayersA, flecs::entity_t B, uint32_t LayersB)
+{
+	if (A < B)
+	{
+		Candidates.push_back({ A, B, LayersA, LayersB });
+	}
+	else
+	{
+		Candidates.push_back({ B, A, LayersB, LayersA });
+	}
+}
+
+static void QueryAABBTree(const CollisionState& Collision, const ColliderProxyComponent& Proxy, flecs::entity_t EntityID, uint32_t Layers, uint32_t Mask, std::vector<CollisionCandidate>& Candidates)
+{
+	if (Proxy.IsStatic || Proxy.Proxy == AABBTree::NullNode)
+	{
+		return;
+	}
+
+	const AABBTree& DynamicTree = Collision.DynamicTree;
+	const AABBTree& StaticTree = Collision.StaticTree;
+	const AABB& Bounds = DynamicTree.GetBounds(Proxy.Proxy);
+
+	DynamicTree.Query(Bounds, Mask, [&](int32_t Other)
+	{
+		const flecs::entity_t OtherID = DynamicTree.GetUserData(Other);
+		if (OtherID > EntityID && Bounds.Overlaps(DynamicTree.GetBounds(Other)))
+		{
+			PushCandidate(Candidates, EntityID, Layers, OtherID, DynamicTree.GetLayers(Other));
+		}
+	});
+
+	StaticTree.Query(Bounds, Mask, [&](int32_t Other)
+	{
+		if (Bounds.Overlaps(StaticTree.GetBounds(Other)))
+		{
+			PushCandidate(Candidates, EntityID, Layers, StaticTree.GetUserData(Other), StaticTree.GetLayers(Other));
+		}
+	});
+}
+
+static void QuerySpatialHash(const CollisionState& Collision, const AABB& Bounds, flecs::entity_t EntityID, uint32_t Layers, uint32_t Mask, std::vector<CollisionCandidate>& Candidates)
+{
+	Collision.Grid.Query(Bounds, Collision.ColliderBounds, Mask, [&](uint32_t Other)
+	{
+		const flecs::entity_t OtherID = Collision.ColliderIDs[Other];
+		if (Collision.ColliderIsStatic[Other] || OtherID > EntityID)
+		{
+			PushCandidate(Candidates, EntityID, Layers, OtherID, Collision.ColliderLayers[Other]);
+		}
+	});
+}
+
+static void CollisionBroadphaseSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
+	auto& Collision = World.get_mut<CollisionState>();
+	auto& Workers = World.get_mut<CollisionWorkerState>();
+	Workers.Candidates.resize(static_cast<size_t>(World.get_stage_count()));
+	for (auto& Candidates : Workers.Candidates)
+	{
+		Candidates.clear();
+	}
+
+	CreatePendingStaticProxies(World, Collision);
+	if (Collision.Broadphase == BroadphaseMode::SpatialHash)
+	{
+		RebuildSpatialHash(World, Collision);
+	}
+	else
+	{
+		RefitDynamicTree(World, Collision);
+	}
+}
+
+// Runs on the flecs worker threads, each one over its own slice of the moving bodies and appending
+// to its own stage's buffer. Only moving bodies query, so static-vs-static pairs are never generated,
+// and the layer mask rejects pairs that do not interact before any bounds are compared.
+static void CollisionDetectionSystemTask(flecs::iter& Iter, size_t Row, const TransformComponent& Transform, const BoxColliderComponent& Collider, const ColliderProxyComponent& Proxy, CollisionWorkerState& Workers)
 {
 	auto World = Iter.world();
-	struct CollidableEntity
+	const auto& Collision = World.get<CollisionState>();
+	const uint32_t Mask = Collision.LayerMatrix.GetMask(Collider.Layers);
+	if (Mask == CollisionLayer::None)
+	{
+		return;
+	}
+
+	auto& Candidates = Workers.Candidates[static_cast<size_t>(World.get_stage_id())];
+	const flecs::entity_t EntityID = Iter.entity(Row).id();
+	if (Collision.Broadphase == BroadphaseMode::SpatialHash)
+	{
+		QuerySpatialHash(Collision, AABB::FromCollider(Transform, Collider), EntityID, Collider.Layers, Mask, Candidates);
+	}
+	else
 	{
-		flecs::entity Entity;
-		TransformComponent Transform;
-		BoxColliderComponent Collider;
-	};
+		QueryAABBTree(Collision, Proxy, EntityID, Collider.Layers, Mask, Candidates);
+	}
+}
 
+static void CollisionMergeSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
 	auto& Collision = World.get_mut<CollisionState>();
-	Collision.Pairs.clear();
 
-	std::vector<CollidableEntity> Entities;
-	World.each([&Entities](flecs::entity Entity, const TransformComponent& Transform, const BoxColliderComponent& Collider)
+	Collision.MergedCandidates.clear();
+	for (const auto& Candidates : World.get<CollisionWorkerState>().Candidates)
 	{
-		Entities.push_back({ Entity, Transform, Collider });
+		Collision.MergedCandidates.insert(Collision.MergedCandidates.end(), Candidates.begin(), Candidates.end());
+	}
+
+	std::sort(Collision.MergedCandidates.begin(), Collision.MergedCandidates.end(), [](const CollisionCandidate& A, const CollisionCandidate& B)
+	{
+		return A.A != B.A ? A.A < B.A : A.B < B.B;
 	});
 
-	for (auto A = Entities.begin(); A != Entities.end(); ++A)
-	{
-		for (auto B = std::next(A); B != Entities.end(); ++B)
-		{
-			const bool IsColliding = CheckAABBCollision
-			(
-				A->Transform.Position.x + A->Collider.Offset.x,
-				A->Transform.Position.y + A->Collider.Offset.y,
-				A->Collider.Width * A->Transform.Scale.x,
-				A->Collider.Height * A->Transform.Scale.y,
-				B->Transform.Position.x + B->Collider.Offset.x,
-				B->Transform.Position.y + B->Collider.Offset.y,
-				B->Collider.Width * B->Transform.Scale.x,
-				B->Collider.Height * B->Transform.Scale.y
-			);
-
-			if (IsColliding)
-			{
-				Collision.Pairs.push_back({ A->Entity, B->Entity });
-			}
-		}
+	Collision.Pairs.clear();
+	MergeContacts(Collision.MergedCandidates, Collision.Contacts, [&World, &Collision](const CollisionCandidate& Candidate, ContactEvent Event)
+	{
+		Collision.Pairs.push_back(CollisionPair{ flecs::entity(World.c_ptr(), Candidate.A), flecs::entity(World.c_ptr(), Candidate.B), Candidate.LayersA, Candidate.LayersB, Event });
+	});
+
+	Collision.Contacts.assign(Collision.MergedCandidates.begin(), Collision.MergedCandidates.end());
+}
+
+void CallCollisionScript(flecs::world& World, flecs::entity Entity, flecs::entity Other, ContactEvent Event)
+{
+	if (!IsAlive(World, Entity) || !Entity.has<CollisionScriptComponent>())
+	{
+		return;
+	}
+
+	const auto& Script = Entity.get<CollisionScriptComponent>();
+	const sol::function& Funct = Event == ContactEvent::Begin ? Script.OnEnter : Script.OnExit;
+	if (Funct.valid())
+	{
+		Funct(ScriptEntity(World.c_ptr(), Entity.id()), ScriptEntity(World.c_ptr(), Other.id()));
 	}
 }
 
@@ -123,49 +355,97 @@ static void CollisionResponseSystemTask(flecs::iter& Iter, size_t)
 	auto World = Iter.world();
 	const auto& Collision = World.get<CollisionState>();
 
+	// Only contacts that began or ended this frame are dispatched; persisting ones were already
+	// handled when they began. Pair layers mirror the gameplay tags, so the dispatch below needs
+	// no per-pair has<>() lookups.
 	for (const auto& Pair : Collision.Pairs)
 	{
+		if (Pair.Event == ContactEvent::Persist)
+		{
+			continue;
+		}
+
+		if (Pair.Event == ContactEvent::End)
+		{
+			CallCollisionScript(World, Pair.A, Pair.B, ContactEvent::End);
+			CallCollisionScript(World, Pair.B, Pair.A, ContactEvent::End);
+			continue;
+		}
+
 		if (!IsAlive(World, Pair.A) || !IsAlive(World, Pair.B))
 		{
 			continue;
 		}
 
-		if (Pair.A.has<EnemiesTag>() && Pair.B.has<ObstaclesTag>())
+		const auto InLayer = [](uint32_t Layers, uint32_t Layer)
+		{
+			return (Layers & Layer) != 0;
+		};
+
+		if (InLayer(Pair.LayersA, CollisionLayer::Enemies) && InLayer(Pair.LayersB, CollisionLayer::Obstacles))
 		{
 			BounceEnemyOffObstacle(Pair.A);
 		}
-		else if (Pair.B.has<EnemiesTag>() && Pair.A.has<ObstaclesTag>())
+		else if (InLayer(Pair.LayersB, CollisionLayer::Enemies) && InLayer(Pair.LayersA, CollisionLayer::Obstacles))
 		{
 			BounceEnemyOffObstacle(Pair.B);
 		}
 
-		if (Pair.A.has<ProjectilesTag>() && Pair.B.has<PlayerTag>())
+		if (InLayer(Pair.LayersA, CollisionLayer::Projectiles) && InLayer(Pair.LayersB, CollisionLayer::Player))
 		{
 			HandleProjectileHitsHealthTarget(Pair.A, Pair.B, true);
 		}
-		else if (Pair.B.has<ProjectilesTag>() && Pair.A.has<PlayerTag>())
+		else if (InLayer(Pair.LayersB, CollisionLayer::Projectiles) && InLayer(Pair.LayersA, CollisionLayer::Player))
 		{
 			HandleProjectileHitsHealthTarget(Pair.B, Pair.A, true);
 		}
 
-		if (Pair.A.has<ProjectilesTag>() && Pair.B.has<EnemiesTag>())
+		if (InLayer(Pair.LayersA, CollisionLayer::Projectiles) && InLayer(Pair.LayersB, CollisionLayer::Enemies))
 		{
 			HandleProjectileHitsHealthTarget(Pair.A, Pair.B, false);
 		}
-		else if (Pair.B.has<ProjectilesTag>() && Pair.A.has<EnemiesTag>())
+		else if (InLayer(Pair.LayersB, CollisionLayer::Projectiles) && InLayer(Pair.LayersA, CollisionLayer::Enemies))
 		{
 			HandleProjectileHitsHealthTarget(Pair.B, Pair.A, false);
 		}
+
+		CallCollisionScript(World, Pair.A, Pair.B, ContactEvent::Begin);
+		CallCollisionScript(World, Pair.B, Pair.A, ContactEvent::Begin);
 	}
 }
 
 void RegisterCollisionSystems(flecs::world& World)
 {
+	World.observer<const TransformComponent, const BoxColliderComponent>("ColliderProxySetObserver")
+		.event(flecs::OnSet)
+		.each(ColliderProxySetObserverTask);
+
+	World.observer<const TransformComponent, const BoxColliderComponent>("ColliderProxyRemoveObserver")
+		.event(flecs::OnRemove)
+		.each(ColliderProxyRemoveObserverTask);
+
+	World.observer<const RigidBodyComponent>("ColliderProxyBodyObserver")
+		.event(flecs::OnAdd)
+		.event(flecs::OnRemove)
+		.each(ColliderProxyBodyObserverTask);
+
 	const auto DetectPhase = World.lookup(CollisionDetectPhaseName);
-	World.system("CollisionDetectionSystem")
+	World.system("CollisionBroadphaseSystem")
+		.kind(DetectPhase.id())
+		.each(CollisionBroadphaseSystemTask);
+
+	// The worker buffers are an explicit singleton term, so flecs knows this system writes them.
+	World.system<const TransformComponent, const BoxColliderComponent, const ColliderProxyComponent, CollisionWorkerState>("CollisionDetectionSystem")
+		.term_at(3).singleton()
+		.with<RigidBodyComponent>()
 		.kind(DetectPhase.id())
+		.multi_threaded()
 		.each(CollisionDetectionSystemTask);
 
+	World.system("CollisionMergeSystem")
+		.kind(DetectPhase.id())
+		.each(CollisionMergeSystemTask);
+
 	const auto ResponsePhase = World.lookup(CollisionResponsePhaseName);
 	World.system("CollisionResponseSystem")
 		.kind(ResponsePhase.id())
@@ -1,21 +1,29 @@
 #include "FlecsGameWorld.hpp"
 #include "FlecsSystems.hpp"
+#include "../AssetManager/AssetManager.hpp"
 #include "../Components/AnimationComponent.hpp"
 #include "../Components/BoxColliderComponent.hpp"
 #include "../Components/CameraFollowComponent.hpp"
+#include "../Components/ColliderProxyComponent.hpp"
 #include "../Components/HealthComponent.hpp"
+#include "../Components/InterpolationComponent.hpp"
 #include "../Components/KeyboardControlComponent.hpp"
+#include "../Components/ParticleBurstComponent.hpp"
+#include "../Components/ParticleEmitterComponent.hpp"
 #include "../Components/ProjectileComponent.hpp"
 #include "../Components/ProjectileEmitterComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
+#include "../Components/SpriteProxyComponent.hpp"
 #include "../Components/TextLabelComponent.hpp"
 #include "../Components/TransformComponent.hpp"
 
 #include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
 
 #include <algorithm>
 #include <cctype>
+#include <iterator>
 #include <string_view>
 
 static std::string NormalizeTag(std::string_view Tag)
@@ -36,10 +44,28 @@ static flecs::entity CreatePhase(flecs::world& World, const char* Name, flecs::e
 {
 	auto Phase = World.entity(Name);
 	ecs_add_id(World.c_ptr(), Phase.id(), EcsPhase);
-	ecs_add_pair(World.c_ptr(), Phase.id(), EcsDependsOn, DependsOn);
+	if (DependsOn != 0)
+	{
+		ecs_add_pair(World.c_ptr(), Phase.id(), EcsDependsOn, DependsOn);
+	}
 	return Phase;
 }
 
+RenderCommandList& RenderState::GetRecordingList()
+{
+	return CommandLists[RecordingList];
+}
+
+const RenderCommandList& RenderState::GetPresentList() const
+{
+	return CommandLists[RecordingList ^ 1];
+}
+
+void RenderState::SwapCommandLists()
+{
+	RecordingList ^= 1;
+}
+
 void InputState::Clear()
 {
 	PressedKeys.clear();
@@ -70,6 +96,12 @@ void ScriptEntity::Destroy() const
 bool ScriptEntity::HasTag(const std::string& Tag) const
 {
 	auto Entity = ToEntity();
+	// Collision exit hooks can receive an entity that was destroyed since the contact began.
+	if (Entity.id() == 0 || !Entity.is_alive())
+	{
+		return false;
+	}
+
 	flecs::world WorldHandle(World);
 	return HasGameplayTag(WorldHandle, Entity, Tag);
 }
@@ -92,13 +124,18 @@ flecs::entity ScriptEntity::ToEntity() const
 void RegisterFlecsGameWorld(flecs::world& World)
 {
 	World.component<TransformComponent>("TransformComponent");
+	World.component<InterpolationComponent>("InterpolationComponent");
 	World.component<RigidBodyComponent>("RigidBodyComponent");
 	World.component<SpriteComponent>("SpriteComponent");
+	World.component<SpriteProxyComponent>("SpriteProxyComponent");
 	World.component<AnimationComponent>("AnimationComponent");
 	World.component<BoxColliderComponent>("BoxColliderComponent");
+	World.component<ColliderProxyComponent>("ColliderProxyComponent");
 	World.component<HealthComponent>("HealthComponent");
 	World.component<ProjectileEmitterComponent>("ProjectileEmitterComponent");
 	World.component<ProjectileComponent>("ProjectileComponent");
+	World.component<ParticleEmitterComponent>("ParticleEmitterComponent");
+	World.component<ParticleBurstComponent>("ParticleBurstComponent");
 	RegisterScriptComponents(World);
 	World.component<KeyboardControlComponent>("KeyboardControlComponent");
 	World.component<CameraFollowComponent>("CameraFollowComponent");
@@ -111,27 +148,48 @@ void RegisterFlecsGameWorld(flecs::world& World)
 	World.component<TilesTag>("Tiles");
 	World.component<UiTag>("Ui");
 	World.component<PendingDestroyTag>("PendingDestroy");
+	World.component<PooledProjectileTag>("PooledProjectile");
+	World.component<LevelEntityTag>("LevelEntity");
+	World.component<SimulationPhaseTag>("SimulationPhase");
+	World.component<RenderPhaseTag>("RenderPhase");
 
 	World.component<GameContext>("GameContext");
 	World.component<InputState>("InputState");
 	World.component<MapBounds>("MapBounds");
 	World.component<CollisionState>("CollisionState");
+	World.component<CollisionWorkerState>("CollisionWorkerState");
+	World.component<RenderState>("RenderState");
+	World.component<ParticleState>("ParticleState");
+	World.component<ProjectilePoolState>("ProjectilePoolState");
 
+	// Simulation and render phases form two separate chains so each can run in its own pipeline.
 	flecs::entity_t PreviousPhase = EcsOnUpdate;
-	PreviousPhase = CreatePhase(World, InputPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, MovementPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, ProjectilePhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, AnimationPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, CollisionDetectPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, CollisionResponsePhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, CameraPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, ScriptPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, RenderBeginPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, RenderWorldPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, RenderUiPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, RenderDebugPhaseName, PreviousPhase).id();
-	PreviousPhase = CreatePhase(World, RenderEndPhaseName, PreviousPhase).id();
-	CreatePhase(World, CleanupPhaseName, PreviousPhase);
+	for (const char* PhaseName : { InputPhaseName, MovementPhaseName, ProjectilePhaseName, AnimationPhaseName, CollisionDetectPhaseName, CollisionResponsePhaseName, CameraPhaseName, ScriptPhaseName, CleanupPhaseName })
+	{
+		PreviousPhase = CreatePhase(World, PhaseName, PreviousPhase).add<SimulationPhaseTag>().id();
+	}
+
+	PreviousPhase = 0;
+	for (const char* PhaseName : { RenderBeginPhaseName, RenderWorldPhaseName, RenderUiPhaseName, RenderDebugPhaseName, RenderEndPhaseName })
+	{
+		PreviousPhase = CreatePhase(World, PhaseName, PreviousPhase).add<RenderPhaseTag>().id();
+	}
+}
+
+static flecs::entity CreatePipeline(flecs::world& World, flecs::entity_t PhaseTag)
+{
+	return World.pipeline()
+		.with(flecs::System)
+		.with(flecs::Phase).cascade(flecs::DependsOn)
+		.with(PhaseTag).up(flecs::DependsOn)
+		.without(flecs::Disabled).up(flecs::DependsOn)
+		.without(flecs::Disabled).up(flecs::ChildOf)
+		.build();
+}
+
+FramePipelines CreateFramePipelines(flecs::world& World)
+{
+	return FramePipelines{ CreatePipeline(World, World.id<SimulationPhaseTag>()), CreatePipeline(World, World.id<RenderPhaseTag>()) };
 }
 
 void RegisterFlecsSystems(flecs::world& World)
@@ -141,6 +199,7 @@ void RegisterFlecsSystems(flecs::world& World)
 	RegisterMovementSystems(World);
 	RegisterProjectileSystems(World);
 	RegisterAnimationSystems(World);
+	RegisterParticleSystems(World);
 	RegisterCollisionSystems(World);
 	RegisterCameraSystems(World);
 	RegisterScriptSystems(World);
@@ -148,8 +207,22 @@ void RegisterFlecsSystems(flecs::world& World)
 	RegisterCleanupSystems(World);
 }
 
+static void AddCollisionLayer(flecs::entity Entity, uint32_t Layer)
+{
+	if (Layer == CollisionLayer::None || !Entity.has<BoxColliderComponent>())
+	{
+		return;
+	}
+
+	auto& Collider = Entity.ensure<BoxColliderComponent>();
+	Collider.Layers = (Collider.Layers & ~CollisionLayer::Default) | Layer;
+	Entity.modified<BoxColliderComponent>();
+}
+
 void ApplyGameplayTag(flecs::world& World, flecs::entity Entity, const std::string& Tag)
 {
+	AddCollisionLayer(Entity, GetCollisionLayer(Tag));
+
 	const std::string Normalized = NormalizeTag(Tag);
 	if (Normalized == "player")
 	{
@@ -214,22 +287,131 @@ bool HasGameplayTag(flecs::world& World, flecs::entity Entity, const std::string
 	return DynamicTag.id() != 0 && ecs_has_id(World.c_ptr(), Entity.id(), DynamicTag.id());
 }
 
+uint32_t GetCollisionLayer(const std::string& Tag)
+{
+	const std::string Normalized = NormalizeTag(Tag);
+	if (Normalized == "default")
+	{
+		return CollisionLayer::Default;
+	}
+	if (Normalized == "player")
+	{
+		return CollisionLayer::Player;
+	}
+	if (Normalized == "enemies")
+	{
+		return CollisionLayer::Enemies;
+	}
+	if (Normalized == "obstacles")
+	{
+		return CollisionLayer::Obstacles;
+	}
+	if (Normalized == "projectiles")
+	{
+		return CollisionLayer::Projectiles;
+	}
+	if (Normalized == "tiles")
+	{
+		return CollisionLayer::Tiles;
+	}
+	if (Normalized == "ui")
+	{
+		return CollisionLayer::Ui;
+	}
+
+	return CollisionLayer::None;
+}
+
 void MarkForDestroy(flecs::entity Entity)
 {
-	if (Entity.id() != 0 && !Entity.has<PendingDestroyTag>())
+	if (Entity.id() == 0)
+	{
+		return;
+	}
+
+	// Pooled projectiles are handed back to the pool at cleanup instead of being deleted.
+	if (Entity.has<PooledProjectileTag>())
+	{
+		Entity.world().get_mut<ProjectilePoolState>().PendingRelease.push_back(Entity.id());
+		return;
+	}
+
+	if (!Entity.has<PendingDestroyTag>())
 	{
 		Entity.add<PendingDestroyTag>();
 	}
 }
 
-flecs::entity SpawnProjectile(flecs::world& World, const glm::vec2& Position, const glm::vec2& Velocity, const ProjectileEmitterComponent& Emitter)
+// Creates the missing entities in a single bulk operation, already in the archetype an active
+// projectile ends up in, only disabled.
+void ReserveProjectiles(flecs::world& World, uint32_t Capacity)
+{
+	auto& Pool = World.get_mut<ProjectilePoolState>();
+	if (Capacity <= Pool.Capacity)
+	{
+		return;
+	}
+
+	ecs_bulk_desc_t Description = {};
+	Description.count = static_cast<int32_t>(Capacity - Pool.Capacity);
+	const ecs_id_t Ids[] =
+	{
+		World.id<ProjectilesTag>(),
+		World.id<PooledProjectileTag>(),
+		World.id<TransformComponent>(),
+		World.id<InterpolationComponent>(),
+		World.id<RigidBodyComponent>(),
+		World.id<SpriteComponent>(),
+		World.id<SpriteProxyComponent>(),
+		World.id<BoxColliderComponent>(),
+		World.id<ColliderProxyComponent>(),
+		World.id<ProjectileComponent>(),
+		EcsDisabled
+	};
+	std::copy(std::begin(Ids), std::end(Ids), Description.ids);
+
+	const ecs_entity_t* Entities = ecs_bulk_init(World.c_ptr(), &Description);
+	Pool.Free.insert(Pool.Free.end(), Entities, Entities + Description.count);
+	Pool.Capacity = Capacity;
+}
+
+// Doubles the pool, or more if that is not enough for the spawns still waiting for an entity.
+void GrowProjectilePool(flecs::world& World)
+{
+	const auto& Pool = World.get<ProjectilePoolState>();
+	if (Pool.PendingSpawns.size() <= Pool.Free.size())
+	{
+		return;
+	}
+
+	const uint32_t Missing = static_cast<uint32_t>(Pool.PendingSpawns.size() - Pool.Free.size());
+	const uint32_t Capacity = (std::max)(Pool.Capacity * 2, Pool.Capacity + Missing);
+	spdlog::info("Growing the projectile pool from {} to {} entities", Pool.Capacity, Capacity);
+	ReserveProjectiles(World, Capacity);
+}
+
+void DestroyLevelEntities(flecs::world& World)
+{
+	World.delete_with<LevelEntityTag>();
+
+	// Disabled projectiles are already in the pool, so this only matches the ones in flight.
+	auto& Pool = World.get_mut<ProjectilePoolState>();
+	Pool.PendingSpawns.clear();
+	World.query_builder().with<PooledProjectileTag>().build().each([&Pool](flecs::entity Projectile)
+	{
+		Pool.PendingRelease.push_back(Projectile.id());
+	});
+	ReleasePendingProjectiles(World);
+
+	// What is left in the contact cache refers to entities that no longer exist.
+	auto& Collision = World.get_mut<CollisionState>();
+	Collision.Pairs.clear();
+	Collision.Contacts.clear();
+	Collision.ReleasedContacts.clear();
+	Collision.PendingStaticProxies.clear();
+}
+
+void SpawnProjectile(flecs::world& World, const glm::vec2& Position, const glm::vec2& Velocity, const ProjectileEmitterComponent& Emitter)
 {
-	auto Projectile = World.entity();
-	Projectile.add<ProjectilesTag>();
-	Projectile.set<TransformComponent>(TransformComponent(Position, glm::vec2(1.0f, 1.0f), 0.0));
-	Projectile.set<RigidBodyComponent>(RigidBodyComponent(Velocity));
-	Projectile.set<SpriteComponent>(SpriteComponent("bullet-texture", 4, 4, 4));
-	Projectile.set<BoxColliderComponent>(BoxColliderComponent(4, 4));
-	Projectile.set<ProjectileComponent>(ProjectileComponent(Emitter.IsFriendly, Emitter.HitPercentDamage, Emitter.ProjectileDuration));
-	return Projectile;
+	World.get_mut<ProjectilePoolState>().PendingSpawns.push_back({ Position, Velocity, Emitter.IsFriendly, Emitter.HitPercentDamage, Emitter.ProjectileDuration });
 }
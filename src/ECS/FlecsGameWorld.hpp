@@ -1,5 +1,15 @@
 #pragma once
 
+#include "../Collision/AABB.hpp"
+#include "../Collision/AABBTree.hpp"
+#include "../Collision/CollisionLayers.hpp"
+#include "../Collision/ContactCache.hpp"
+#include "../Collision/SpatialHashGrid.hpp"
+#include "../Particles/ParticleSystem.hpp"
+#include "../Render/RenderCommandList.hpp"
+#include "../Render/SpriteBatch.hpp"
+#include "../Render/TextCache.hpp"
+
 #include <SDL3/SDL.h>
 #include <flecs.h>
 #include <glm/vec2.hpp>
@@ -7,9 +17,12 @@
 
 #include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class AssetManager;
+class AudioMixer;
+class Tilemap;
 struct ProjectileEmitterComponent;
 
 struct PlayerTag {};
@@ -19,6 +32,18 @@ struct ProjectilesTag {};
 struct TilesTag {};
 struct UiTag {};
 struct PendingDestroyTag {};
+struct PooledProjectileTag {};
+// Everything a level creates, so loading the next one can destroy it in one go.
+struct LevelEntityTag {};
+struct SimulationPhaseTag {};
+struct RenderPhaseTag {};
+
+// Leaf layers of the sprite visibility trees. Fixed sprites are positioned relative to the screen.
+namespace SpriteSpace
+{
+	inline constexpr uint32_t World = 1u << 0;
+	inline constexpr uint32_t Screen = 1u << 1;
+}
 
 struct GameContext
 {
@@ -27,6 +52,8 @@ struct GameContext
 	SDL_FRect* Camera = nullptr;
 	bool* IsDebug = nullptr;
 	bool* IsRunning = nullptr;
+	Tilemap* Map = nullptr;
+	AudioMixer* Audio = nullptr;
 };
 
 struct InputState
@@ -49,11 +76,123 @@ struct CollisionPair
 {
 	flecs::entity A;
 	flecs::entity B;
+	uint32_t LayersA = CollisionLayer::None;
+	uint32_t LayersB = CollisionLayer::None;
+	ContactEvent Event = ContactEvent::Begin;
+};
+
+enum class BroadphaseMode : uint8_t
+{
+	AABBTree,
+	SpatialHash
 };
 
 struct CollisionState
 {
+	// This frame's contacts, including the ones that ended since last frame, sorted by entity ids.
 	std::vector<CollisionPair> Pairs;
+	// The grid is the default: rebuilding it every frame costs less than querying the trees at every
+	// collider count CollisionBenchmark measures.
+	BroadphaseMode Broadphase = BroadphaseMode::SpatialHash;
+	CollisionLayerMatrix LayerMatrix;
+
+	// Persistent trees: colliders with a RigidBodyComponent live in DynamicTree, the rest in StaticTree.
+	AABBTree DynamicTree = AABBTree(AABBTree::DefaultMargin);
+	AABBTree StaticTree = AABBTree(0.0f);
+
+	// Spatial hash broadphase, rebuilt every frame from these flat arrays.
+	SpatialHashGrid Grid;
+	std::vector<flecs::entity_t> ColliderIDs;
+	std::vector<AABB> ColliderBounds;
+	std::vector<uint8_t> ColliderIsStatic;
+	std::vector<uint32_t> ColliderLayers;
+
+	// Colliders that lost their rigid body. Their dynamic proxy is destroyed right away and the static
+	// one is created by the broadphase, so a collider that is being deleted is only torn down once.
+	std::vector<flecs::entity_t> PendingStaticProxies;
+
+	std::vector<CollisionCandidate> MergedCandidates;
+
+	// Pair cache: last frame's overlapping pairs, sorted by (A, B) with A < B, used to tell
+	// beginning contacts from persisting ones and to detect the ones that ended.
+	std::vector<CollisionCandidate> Contacts;
+	// Contacts of pooled projectiles taken out of the cache when they were released.
+	std::vector<CollisionCandidate> ReleasedContacts;
+};
+
+// Candidate buffers of the multi-threaded collision detection, one per flecs stage. Kept apart from
+// CollisionState so the detection system can declare that it writes these while only reading that.
+struct CollisionWorkerState
+{
+	std::vector<std::vector<CollisionCandidate>> Candidates;
+};
+
+struct RenderState
+{
+	// Set by the game before the render pipeline runs: how far the frame is between the last two
+	// simulation ticks, and the camera blended accordingly.
+	float InterpolationAlpha = 1.0f;
+	SDL_FRect Camera = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// When set, the world is drawn into the top-left RenderScale of this native-sized texture and
+	// stretched over the window before the HUD, which stays at native resolution.
+	SDL_Texture* WorldTarget = nullptr;
+	float RenderScale = 1.0f;
+
+	// Double-buffered: the render systems record into one list while the game executes the other.
+	RenderCommandList CommandLists[2];
+	uint32_t RecordingList = 0;
+
+	RenderCommandList& GetRecordingList();
+	const RenderCommandList& GetPresentList() const;
+	void SwapCommandLists();
+
+	SpriteBatch Sprites;
+	SpriteBatch HealthBars;
+	// Reused for the particle quads of one texture at a time.
+	std::vector<SDL_Vertex> ParticleVertices;
+
+	// One visibility tree per z-index, so walking them in order yields the visible sprites already
+	// sorted. Leaves are tagged with the SpriteSpace the sprite is positioned in.
+	std::vector<AABBTree> SpriteTrees = std::vector<AABBTree>(256);
+
+	// Text labels keep their cache entry pinned until their TextLabelComponent changes or goes away.
+	TextCache Text;
+	std::unordered_map<flecs::entity_t, TextCache::Entry*> LabelTextures;
+	// Labels removed during the simulation, which runs while the previous frame is presented. Their
+	// entries are released by the text label cache system on the main thread, once that present is done.
+	std::vector<flecs::entity_t> RemovedLabels;
+};
+
+struct ProjectileSpawn
+{
+	glm::vec2 Position;
+	glm::vec2 Velocity;
+	bool IsFriendly;
+	uint8_t HitPercentDamage;
+	uint16_t Duration;
+};
+
+// Projectile entities are created up front in their final archetype, disabled, and recycled
+// instead of deleted: spawning enables a free one, destroying disables it again. Spawns are queued
+// and activated together once per tick. Spawns that find the pool empty wait for the game to grow
+// it between frames, since entities cannot be bulk-created while a pipeline is running.
+struct ProjectilePoolState
+{
+	static constexpr uint32_t DefaultCapacity = 256;
+
+	std::vector<flecs::entity_t> Free;
+	std::vector<ProjectileSpawn> PendingSpawns;
+	std::vector<flecs::entity_t> PendingRelease;
+	uint32_t Capacity = 0;
+	uint32_t ActiveCount = 0;
+	uint32_t HighWaterMark = 0;
+};
+
+// Particles are simulated with the gameplay phases and read by the render systems afterwards.
+struct ParticleState
+{
+	ParticleSystem Particles;
 };
 
 struct ScriptEntity
@@ -71,15 +210,38 @@ struct ScriptEntity
 	flecs::entity ToEntity() const;
 };
 
+// The simulation pipeline runs every phase up to and including cleanup; the render pipeline only
+// records the frame's render commands. Each is run with flecs::world::run_pipeline.
+struct FramePipelines
+{
+	flecs::entity Simulation;
+	flecs::entity Render;
+};
+
 void RegisterFlecsGameWorld(flecs::world& World);
 void RegisterFlecsSystems(flecs::world& World);
+FramePipelines CreateFramePipelines(flecs::world& World);
 void RegisterScriptBindings(flecs::world& World, sol::state& LuaState);
 
 void ApplyGameplayTag(flecs::world& World, flecs::entity Entity, const std::string& Tag);
 bool HasGameplayTag(flecs::world& World, flecs::entity Entity, const std::string& Tag);
+uint32_t GetCollisionLayer(const std::string& Tag);
 void MarkForDestroy(flecs::entity Entity);
+// Calls Entity's on_enter or on_exit hook with Other, if Entity is alive and has one.
+void CallCollisionScript(flecs::world& World, flecs::entity Entity, flecs::entity Other, ContactEvent Event);
+
+// Projectile pool management; neither may be called while a pipeline is running.
+void ReserveProjectiles(flecs::world& World, uint32_t Capacity);
+void GrowProjectilePool(flecs::world& World);
+// Destroys the current level's entities and returns its projectiles to the pool. Like the pool
+// functions above, it may not be called while a pipeline is running.
+void DestroyLevelEntities(flecs::world& World);
+
+// Muzzle flash of Entity's ParticleBurstComponent, if it has one.
+void EmitFireParticles(flecs::world& World, flecs::entity Entity, const glm::vec2& Position);
 
-flecs::entity SpawnProjectile
+// Queues a projectile; it is taken from the pool at the end of the projectile phase.
+void SpawnProjectile
 (
 	flecs::world& World,
 	const glm::vec2& Position,
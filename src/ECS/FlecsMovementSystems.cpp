@@ -1,4 +1,5 @@
 #include "FlecsSystems.hpp"
+#include "../Components/InterpolationComponent.hpp"
 #include "../Components/KeyboardControlComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
@@ -36,11 +37,16 @@ static void KeyboardControlSystemTask(flecs::iter& Iter, size_t, const KeyboardC
 	}
 }
 
-static void MovementSystemTask(flecs::iter& Iter, size_t Row, TransformComponent& Transform, const RigidBodyComponent& RigidBody)
+static void MovementSystemTask(flecs::iter& Iter, size_t Row, TransformComponent& Transform, const RigidBodyComponent& RigidBody, InterpolationComponent* Interpolation)
 {
 	auto World = Iter.world();
 	flecs::entity Entity = Iter.entity(Row);
 	const auto& Bounds = World.get<MapBounds>();
+	if (Interpolation)
+	{
+		Interpolation->PreviousPosition = Transform.Position;
+	}
+
 	Transform.Position.x += RigidBody.Velocity.x * Iter.delta_time();
 	Transform.Position.y += RigidBody.Velocity.y * Iter.delta_time();
 
@@ -70,6 +76,27 @@ static void MovementSystemTask(flecs::iter& Iter, size_t Row, TransformComponent
 	}
 }
 
+// Every body gets an interpolation start point, beginning where it currently stands.
+static void InterpolationBodyObserverTask(flecs::iter& Iter, size_t Row, const RigidBodyComponent&)
+{
+	flecs::entity Entity = Iter.entity(Row);
+	if (!Entity.has<InterpolationComponent>())
+	{
+		const glm::vec2 Position = Entity.has<TransformComponent>() ? Entity.get<TransformComponent>().Position : glm::vec2(0, 0);
+		Entity.set<InterpolationComponent>(InterpolationComponent(Position));
+	}
+}
+
+// Transforms changed through set() or modified() are teleports, so they are not interpolated.
+static void InterpolationTransformObserverTask(flecs::iter& Iter, size_t Row, const TransformComponent& Transform)
+{
+	flecs::entity Entity = Iter.entity(Row);
+	if (Entity.has<InterpolationComponent>())
+	{
+		Entity.set<InterpolationComponent>(InterpolationComponent(Transform.Position));
+	}
+}
+
 void RegisterKeyboardControlSystems(flecs::world& World)
 {
 	const auto Phase = World.lookup(InputPhaseName);
@@ -80,8 +107,16 @@ void RegisterKeyboardControlSystems(flecs::world& World)
 
 void RegisterMovementSystems(flecs::world& World)
 {
+	World.observer<const RigidBodyComponent>("InterpolationBodyObserver")
+		.event(flecs::OnAdd)
+		.each(InterpolationBodyObserverTask);
+
+	World.observer<const TransformComponent>("InterpolationTransformObserver")
+		.event(flecs::OnSet)
+		.each(InterpolationTransformObserverTask);
+
 	const auto Phase = World.lookup(MovementPhaseName);
-	World.system<TransformComponent, const RigidBodyComponent>("MovementSystem")
+	World.system<TransformComponent, const RigidBodyComponent, InterpolationComponent*>("MovementSystem")
 		.kind(Phase.id())
 		.each(MovementSystemTask);
 }
\ No newline at end of file
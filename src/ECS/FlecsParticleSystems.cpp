@@ -0,0 +1,80 @@
+#include "FlecsSystems.hpp"
+#include "../Components/ParticleBurstComponent.hpp"
+#include "../Components/ParticleEmitterComponent.hpp"
+#include "../Components/SpriteComponent.hpp"
+#include "../Components/TransformComponent.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+// Effects are centered on the sprite when there is one, like projectiles are.
+static glm::vec2 GetEffectOrigin(flecs::entity Entity, const TransformComponent& Transform)
+{
+	glm::vec2 Origin = Transform.Position;
+	if (const SpriteComponent* Sprite = Entity.try_get<SpriteComponent>())
+	{
+		Origin.x += Transform.Scale.x * Sprite->Width / 2.0f;
+		Origin.y += Transform.Scale.y * Sprite->Height / 2.0f;
+	}
+	return Origin;
+}
+
+static void ParticleUpdateSystemTask(flecs::iter& Iter, size_t)
+{
+	Iter.world().get_mut<ParticleState>().Particles.Update(Iter.delta_time());
+}
+
+static void ParticleEmitterSystemTask(flecs::iter& Iter, size_t Row, ParticleEmitterComponent& Emitter, const TransformComponent& Transform)
+{
+	Emitter.PendingParticles += Emitter.EmissionRate * Iter.delta_time();
+	const float Count = std::floor(Emitter.PendingParticles);
+	if (Count < 1.0f)
+	{
+		return;
+	}
+
+	Emitter.PendingParticles -= Count;
+	auto& Particles = Iter.world().get_mut<ParticleState>().Particles;
+	Particles.Emit(Emitter.Effect, GetEffectOrigin(Iter.entity(Row), Transform), static_cast<uint32_t>(Count));
+}
+
+static void ParticleDestroyObserverTask(flecs::iter& Iter, size_t Row)
+{
+	flecs::entity Entity = Iter.entity(Row);
+	const ParticleBurstComponent* Burst = Entity.try_get<ParticleBurstComponent>();
+	const TransformComponent* Transform = Entity.try_get<TransformComponent>();
+	if (Burst && Transform && Burst->DestroyCount > 0)
+	{
+		auto& Particles = Iter.world().get_mut<ParticleState>().Particles;
+		Particles.Emit(Burst->DestroyEffect, GetEffectOrigin(Entity, *Transform), Burst->DestroyCount);
+	}
+}
+
+void EmitFireParticles(flecs::world& World, flecs::entity Entity, const glm::vec2& Position)
+{
+	const ParticleBurstComponent* Burst = Entity.try_get<ParticleBurstComponent>();
+	if (Burst && Burst->FireCount > 0)
+	{
+		World.get_mut<ParticleState>().Particles.Emit(Burst->FireEffect, Position, Burst->FireCount);
+	}
+}
+
+void RegisterParticleSystems(flecs::world& World)
+{
+	World.observer("ParticleDestroyObserver")
+		.with<PendingDestroyTag>()
+		.event(flecs::OnAdd)
+		.each(ParticleDestroyObserverTask);
+
+	// Existing particles move before this tick's ones are emitted, so new ones start at the emitter.
+	const auto Phase = World.lookup(AnimationPhaseName);
+	World.system("ParticleUpdateSystem")
+		.kind(Phase.id())
+		.each(ParticleUpdateSystemTask);
+
+	World.system<ParticleEmitterComponent, const TransformComponent>("ParticleEmitterSystem")
+		.kind(Phase.id())
+		.each(ParticleEmitterSystemTask);
+}
@@ -1,14 +1,19 @@
 #include "FlecsSystems.hpp"
+#include "../AssetManager/AssetManager.hpp"
+#include "../Components/BoxColliderComponent.hpp"
 #include "../Components/CameraFollowComponent.hpp"
+#include "../Components/ColliderProxyComponent.hpp"
 #include "../Components/ProjectileComponent.hpp"
 #include "../Components/ProjectileEmitterComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
+#include "../Components/SpriteProxyComponent.hpp"
 #include "../Components/TransformComponent.hpp"
 
 #include <SDL3/SDL.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <cstdint>
 
 static glm::vec2 GetProjectileOrigin(flecs::entity Entity, const TransformComponent& Transform)
@@ -44,6 +49,7 @@ static void ProjectileEmitterSystemTask(flecs::iter& Iter, size_t Row, Projectil
 		ProjectileVelocity.x = DirectionX * Emitter.ProjectileVelocity.x;
 		ProjectileVelocity.y = DirectionY * Emitter.ProjectileVelocity.y;
 		SpawnProjectile(World, GetProjectileOrigin(Entity, Transform), ProjectileVelocity, Emitter);
+		EmitFireParticles(World, Entity, GetProjectileOrigin(Entity, Transform));
 	}
 
 	if (Emitter.ProjectileFrequency == 0)
@@ -51,21 +57,125 @@ static void ProjectileEmitterSystemTask(flecs::iter& Iter, size_t Row, Projectil
 		return;
 	}
 
-	if (SDL_GetTicks() - Emitter.LastEmissionTime > Emitter.ProjectileFrequency)
+	Emitter.MillisecondsSinceEmission += Iter.delta_time() * 1000.0f;
+	if (Emitter.MillisecondsSinceEmission > Emitter.ProjectileFrequency)
 	{
 		SpawnProjectile(World, GetProjectileOrigin(Entity, Transform), Emitter.ProjectileVelocity, Emitter);
-		Emitter.LastEmissionTime = SDL_GetTicks();
+		EmitFireParticles(World, Entity, GetProjectileOrigin(Entity, Transform));
+		Emitter.MillisecondsSinceEmission = 0.0f;
 	}
 }
 
 static void ProjectileLifecycleSystemTask(flecs::iter& Iter, size_t Row, ProjectileComponent& Projectile)
 {
-	if (SDL_GetTicks() - Projectile.StartTime > Projectile.Duration)
+	Projectile.AgeMilliseconds += Iter.delta_time() * 1000.0f;
+	if (Projectile.AgeMilliseconds > Projectile.Duration)
 	{
 		MarkForDestroy(Iter.entity(Row));
 	}
 }
 
+// Every spawn queued this tick takes a free entity from the pool in the same deferred batch, so
+// each one costs a single move from the disabled table to the enabled one.
+static void ProjectileSpawnSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
+	auto& Pool = World.get_mut<ProjectilePoolState>();
+	const size_t SpawnCount = (std::min)(Pool.PendingSpawns.size(), Pool.Free.size());
+	if (SpawnCount == 0)
+	{
+		return;
+	}
+
+	const TextureHandle Texture = World.get<GameContext>().Assets->GetTextureHandle("bullet-texture");
+	for (size_t i = 0; i < SpawnCount; ++i)
+	{
+		const ProjectileSpawn& Spawn = Pool.PendingSpawns[i];
+		flecs::entity Projectile(World, Pool.Free.back());
+		Pool.Free.pop_back();
+
+		Projectile.enable();
+		Projectile.set<TransformComponent>(TransformComponent(Spawn.Position, glm::vec2(1.0f, 1.0f), 0.0));
+		Projectile.set<RigidBodyComponent>(RigidBodyComponent(Spawn.Velocity));
+		Projectile.set<SpriteComponent>(SpriteComponent(Texture, 4, 4, 4));
+		Projectile.set<BoxColliderComponent>(BoxColliderComponent(4, 4, glm::vec2(0, 0), CollisionLayer::Projectiles));
+		Projectile.set<ProjectileComponent>(ProjectileComponent(Spawn.IsFriendly, Spawn.HitPercentDamage, Spawn.Duration));
+	}
+
+	Pool.PendingSpawns.erase(Pool.PendingSpawns.begin(), Pool.PendingSpawns.begin() + SpawnCount);
+	Pool.ActiveCount += static_cast<uint32_t>(SpawnCount);
+	Pool.HighWaterMark = (std::max)(Pool.HighWaterMark, Pool.ActiveCount);
+}
+
+// Disabled entities are invisible to every query, including the ones that maintain the sprite and
+// collider trees, so the leaves are taken out here before the projectile goes back to the pool.
+void ReleasePendingProjectiles(flecs::world& World)
+{
+	auto& Pool = World.get_mut<ProjectilePoolState>();
+	if (Pool.PendingRelease.empty())
+	{
+		return;
+	}
+
+	// A projectile can be destroyed twice in one tick, by a hit and by expiring.
+	std::sort(Pool.PendingRelease.begin(), Pool.PendingRelease.end());
+	Pool.PendingRelease.erase(std::unique(Pool.PendingRelease.begin(), Pool.PendingRelease.end()), Pool.PendingRelease.end());
+
+	auto& Render = World.get_mut<RenderState>();
+	auto& Collision = World.get_mut<CollisionState>();
+	for (const flecs::entity_t ProjectileID : Pool.PendingRelease)
+	{
+		flecs::entity Projectile(World, ProjectileID);
+		if (!Projectile.is_alive() || !Projectile.enabled())
+		{
+			continue;
+		}
+
+		auto& SpriteProxy = Projectile.get_mut<SpriteProxyComponent>();
+		if (SpriteProxy.Proxy != AABBTree::NullNode)
+		{
+			Render.SpriteTrees[SpriteProxy.ZIndex].DestroyProxy(SpriteProxy.Proxy);
+			SpriteProxy.Proxy = AABBTree::NullNode;
+		}
+
+		auto& ColliderProxy = Projectile.get_mut<ColliderProxyComponent>();
+		if (ColliderProxy.Proxy != AABBTree::NullNode)
+		{
+			(ColliderProxy.IsStatic ? Collision.StaticTree : Collision.DynamicTree).DestroyProxy(ColliderProxy.Proxy);
+			ColliderProxy.Proxy = AABBTree::NullNode;
+		}
+
+		Projectile.disable();
+		Pool.Free.push_back(ProjectileID);
+		--Pool.ActiveCount;
+	}
+
+	// A recycled projectile keeps its id, so its cached contacts would turn its next hit on the same
+	// partner into a persisting contact, which deals no damage. They end here instead, and only the
+	// partners that are not back in the pool hear about it.
+	EraseContactsOf(Collision.Contacts, Pool.PendingRelease, Collision.ReleasedContacts);
+	for (const CollisionCandidate& Contact : Collision.ReleasedContacts)
+	{
+		const flecs::entity A(World, Contact.A);
+		const flecs::entity B(World, Contact.B);
+		if (!std::binary_search(Pool.PendingRelease.begin(), Pool.PendingRelease.end(), Contact.A))
+		{
+			CallCollisionScript(World, A, B, ContactEvent::End);
+		}
+		if (!std::binary_search(Pool.PendingRelease.begin(), Pool.PendingRelease.end(), Contact.B))
+		{
+			CallCollisionScript(World, B, A, ContactEvent::End);
+		}
+	}
+	Pool.PendingRelease.clear();
+}
+
+static void ProjectileReleaseSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
+	ReleasePendingProjectiles(World);
+}
+
 void RegisterProjectileSystems(flecs::world& World)
 {
 	const auto Phase = World.lookup(ProjectilePhaseName);
@@ -77,4 +187,13 @@ void RegisterProjectileSystems(flecs::world& World)
 	World.system<ProjectileComponent>("ProjectileLifecycleSystem")
 		.kind(Phase.id())
 		.each(ProjectileLifecycleSystemTask);
+
+	World.system("ProjectileSpawnSystem")
+		.kind(Phase.id())
+		.each(ProjectileSpawnSystemTask);
+
+	// Registered before the cleanup systems, so it runs ahead of the deletion of destroyed entities.
+	World.system("ProjectileReleaseSystem")
+		.kind(World.lookup(CleanupPhaseName).id())
+		.each(ProjectileReleaseSystemTask);
 }
\ No newline at end of file
@@ -2,23 +2,26 @@
 #include "../AssetManager/AssetManager.hpp"
 #include "../Components/BoxColliderComponent.hpp"
 #include "../Components/HealthComponent.hpp"
+#include "../Components/InterpolationComponent.hpp"
 #include "../Components/ProjectileEmitterComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
+#include "../Components/SpriteProxyComponent.hpp"
 #include "../Components/TextLabelComponent.hpp"
 #include "../Components/TransformComponent.hpp"
+#include "../Tilemap/Tilemap.hpp"
 
-#include <SDL3_ttf/SDL_ttf.h>
 #include <glm/glm.hpp>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_sdl3.h>
 #include <imgui/imgui_impl_sdlrenderer3.h>
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstdint>
 #include <string>
-#include <vector>
+#include <string_view>
 
 static void RenderBeginSystemTask(flecs::iter& Iter, size_t)
 {
@@ -29,102 +32,344 @@ static void RenderBeginSystemTask(flecs::iter& Iter, size_t)
 		return;
 	}
 
-	SDL_SetRenderDrawColor(Context.Renderer, 21, 21, 21, 255);
-	SDL_RenderClear(Context.Renderer);
+	auto& Render = World.get_mut<RenderState>();
+	auto& Commands = Render.GetRecordingList();
+	Commands.Reset();
+	if (Render.WorldTarget)
+	{
+		Commands.SetTarget(Render.WorldTarget, Render.RenderScale);
+	}
+	Commands.ClearTarget({ 21, 21, 21, 255 });
 }
 
-static void RenderSpriteSystemTask(flecs::iter& Iter, size_t)
+// Upscales the world to the window; everything recorded after this is drawn at native resolution.
+static void RenderWorldResolveSystemTask(flecs::iter& Iter, size_t)
 {
 	auto World = Iter.world();
-	struct RenderableEntity
+	auto& Context = World.get_mut<GameContext>();
+	auto& Render = World.get_mut<RenderState>();
+	if (!Context.Renderer || !Render.WorldTarget)
 	{
-		TransformComponent Transform;
-		SpriteComponent Sprite;
-	};
+		return;
+	}
 
+	const SDL_FRect& Camera = Render.Camera;
+	const SDL_FRect ScaledRectangle = { 0.0f, 0.0f, std::round(Camera.w * Render.RenderScale), std::round(Camera.h * Render.RenderScale) };
+	const SDL_FRect WindowRectangle = { 0.0f, 0.0f, Camera.w, Camera.h };
+	auto& Commands = Render.GetRecordingList();
+	Commands.SetTarget(nullptr, 1.0f);
+	Commands.DrawTextureRegion(Render.WorldTarget, ScaledRectangle, WindowRectangle);
+}
+
+static void RenderTilemapSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
 	auto& Context = World.get_mut<GameContext>();
-	if (!Context.Renderer || !Context.Assets || !Context.Camera)
+	if (!Context.Renderer || !Context.Map || !Context.Camera)
 	{
 		return;
 	}
 
-	const SDL_FRect& Camera = *Context.Camera;
-	std::vector<RenderableEntity> RenderableEntities;
-	World.each([&RenderableEntities, &Camera](const TransformComponent& Transform, const SpriteComponent& Sprite)
+	auto& Render = World.get_mut<RenderState>();
+	Context.Map->Render(Render.GetRecordingList(), Render.Camera);
+}
+
+// Bodies are drawn between where the last tick started and where it ended.
+static glm::vec2 GetRenderPosition(flecs::entity Entity, const TransformComponent& Transform, float Alpha)
+{
+	const InterpolationComponent* Interpolation = Entity.try_get<InterpolationComponent>();
+	return Interpolation ? glm::mix(Interpolation->PreviousPosition, Transform.Position, Alpha) : Transform.Position;
+}
+
+static AABB GetSpriteBounds(const TransformComponent& Transform, const SpriteComponent& Sprite)
+{
+	return AABB
+	(
+		Transform.Position.x,
+		Transform.Position.y,
+		Transform.Position.x + Sprite.Width * Transform.Scale.x,
+		Transform.Position.y + Sprite.Height * Transform.Scale.y
+	);
+}
+
+// Keeps the sprite's leaf in the visibility tree of its z-index. A z-index change moves the leaf to
+// another tree; anything else only updates its bounds.
+static void SpriteProxySetObserverTask(flecs::iter& Iter, size_t Row, const TransformComponent& Transform, const SpriteComponent& Sprite)
+{
+	auto World = Iter.world();
+	flecs::entity Entity = Iter.entity(Row);
+	auto& Render = World.get_mut<RenderState>();
+	const AABB Bounds = GetSpriteBounds(Transform, Sprite);
+	const uint32_t Space = Sprite.IsFixed ? SpriteSpace::Screen : SpriteSpace::World;
+
+	if (!Entity.has<SpriteProxyComponent>())
 	{
-		const bool IsOutsideCameraView =
-			Transform.Position.x + (Transform.Scale.x * Sprite.Width) < Camera.x ||
-			Transform.Position.x > Camera.x + Camera.w ||
-			Transform.Position.y + (Transform.Scale.y * Sprite.Height) < Camera.y ||
-			Transform.Position.y > Camera.y + Camera.h;
+		const int32_t Proxy = Render.SpriteTrees[Sprite.ZIndex].CreateProxy(Bounds, Entity.id(), Space);
+		Entity.set<SpriteProxyComponent>(SpriteProxyComponent(Proxy, Sprite.ZIndex));
+		return;
+	}
+
+	auto& Proxy = Entity.get_mut<SpriteProxyComponent>();
+	if (Proxy.Proxy != AABBTree::NullNode && Proxy.ZIndex == Sprite.ZIndex)
+	{
+		Render.SpriteTrees[Proxy.ZIndex].MoveProxy(Proxy.Proxy, Bounds);
+		Render.SpriteTrees[Proxy.ZIndex].SetProxyLayers(Proxy.Proxy, Space);
+		return;
+	}
 
-		if (!IsOutsideCameraView || Sprite.IsFixed)
+	if (Proxy.Proxy != AABBTree::NullNode)
+	{
+		Render.SpriteTrees[Proxy.ZIndex].DestroyProxy(Proxy.Proxy);
+	}
+	Proxy.Proxy = Render.SpriteTrees[Sprite.ZIndex].CreateProxy(Bounds, Entity.id(), Space);
+	Proxy.ZIndex = Sprite.ZIndex;
+}
+
+static void SpriteProxyRemoveObserverTask(flecs::iter& Iter, size_t Row, const TransformComponent&, const SpriteComponent&)
+{
+	auto World = Iter.world();
+	flecs::entity Entity = Iter.entity(Row);
+	if (!Entity.has<SpriteProxyComponent>())
+	{
+		return;
+	}
+
+	auto& Proxy = Entity.get_mut<SpriteProxyComponent>();
+	if (Proxy.Proxy != AABBTree::NullNode)
+	{
+		World.get_mut<RenderState>().SpriteTrees[Proxy.ZIndex].DestroyProxy(Proxy.Proxy);
+		Proxy.Proxy = AABBTree::NullNode;
+	}
+}
+
+// Bodies move without going through set(), so their leaves are refitted once per frame. The fat
+// bounds absorb small movements, so most of these calls leave the tree untouched.
+static void SpriteProxyRefitSystemTask(flecs::iter& Iter, size_t, const TransformComponent& Transform, const SpriteComponent& Sprite, const SpriteProxyComponent& Proxy)
+{
+	if (Proxy.Proxy != AABBTree::NullNode)
+	{
+		Iter.world().get_mut<RenderState>().SpriteTrees[Proxy.ZIndex].MoveProxy(Proxy.Proxy, GetSpriteBounds(Transform, Sprite));
+	}
+}
+
+// Calls OnVisible(EntityID) for every sprite in Spaces overlapping the camera grown by Padding,
+// layer by layer in ascending z-index. Fixed sprites are tested against the viewport instead.
+template <typename Callback>
+static void ForEachVisibleSprite(const RenderState& Render, const SDL_FRect& Camera, float Padding, uint32_t Spaces, Callback&& OnVisible)
+{
+	const AABB WorldBounds(Camera.x - Padding, Camera.y - Padding, Camera.x + Camera.w + Padding, Camera.y + Camera.h + Padding);
+	const AABB ScreenBounds(-Padding, -Padding, Camera.w + Padding, Camera.h + Padding);
+	for (const AABBTree& Tree : Render.SpriteTrees)
+	{
+		if (Tree.GetProxyCount() == 0)
 		{
-			RenderableEntities.push_back({ Transform, Sprite });
+			continue;
 		}
-	});
 
-	std::sort(RenderableEntities.begin(), RenderableEntities.end(), [](const RenderableEntity& A, const RenderableEntity& B)
+		if (Spaces & SpriteSpace::World)
+		{
+			Tree.Query(WorldBounds, SpriteSpace::World, [&Tree, &WorldBounds, &OnVisible](int32_t Proxy)
+			{
+				if (Tree.GetBounds(Proxy).Overlaps(WorldBounds))
+				{
+					OnVisible(static_cast<flecs::entity_t>(Tree.GetUserData(Proxy)));
+				}
+			});
+		}
+		if (Spaces & SpriteSpace::Screen)
+		{
+			Tree.Query(ScreenBounds, SpriteSpace::Screen, [&Tree, &ScreenBounds, &OnVisible](int32_t Proxy)
+			{
+				if (Tree.GetBounds(Proxy).Overlaps(ScreenBounds))
+				{
+					OnVisible(static_cast<flecs::entity_t>(Tree.GetUserData(Proxy)));
+				}
+			});
+		}
+	}
+}
+
+// Decodes the textures of sprites just outside the screen in the background, so they are resident
+// before they scroll into view. Visible sprites that are still missing are loaded when drawn.
+static void TexturePrefetchSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
+	auto& Context = World.get_mut<GameContext>();
+	if (!Context.Assets || !Context.Assets->HasLazyTextures() || Context.Assets->GetPrefetchRadius() <= 0.0f)
+	{
+		return;
+	}
+
+	const auto& Render = World.get<RenderState>();
+	ForEachVisibleSprite(Render, Render.Camera, Context.Assets->GetPrefetchRadius(), SpriteSpace::World | SpriteSpace::Screen, [&World, &Context](flecs::entity_t EntityID)
 	{
-		return A.Sprite.ZIndex < B.Sprite.ZIndex;
+		Context.Assets->PrefetchTexture(flecs::entity(World, EntityID).get<SpriteComponent>().Texture);
 	});
+}
 
-	for (const auto& Renderable : RenderableEntities)
+static void RecordSprites(flecs::world World, uint32_t Spaces)
+{
+	auto& Context = World.get_mut<GameContext>();
+	if (!Context.Renderer || !Context.Assets || !Context.Camera)
 	{
-		SDL_FRect SourceRectangle = Renderable.Sprite.SrcRect;
+		return;
+	}
+
+	auto& Render = World.get_mut<RenderState>();
+	const SDL_FRect& Camera = Render.Camera;
+	const float Alpha = Render.InterpolationAlpha;
+	auto& Batch = Render.Sprites;
+	Batch.Begin();
+
+	// Only sprites on screen are visited, already in z order, so the batch never has to sort.
+	ForEachVisibleSprite(Render, Camera, 0.0f, Spaces, [&World, &Context, &Camera, Alpha, &Batch](flecs::entity_t EntityID)
+	{
+		const flecs::entity Entity(World, EntityID);
+		const TransformComponent& Transform = Entity.get<TransformComponent>();
+		const SpriteComponent& Sprite = Entity.get<SpriteComponent>();
+		const glm::vec2 Position = GetRenderPosition(Entity, Transform, Alpha);
+
+		const TextureRegion& Region = Context.Assets->GetTextureRegion(Sprite.Texture);
 		SDL_FRect DestinationRectangle =
 		{
-			std::round(static_cast<float>(Renderable.Transform.Position.x - (Renderable.Sprite.IsFixed ? 0.0f : Camera.x))),
-			std::round(static_cast<float>(Renderable.Transform.Position.y - (Renderable.Sprite.IsFixed ? 0.0f : Camera.y))),
-			std::ceil(static_cast<float>(Renderable.Sprite.Width * Renderable.Transform.Scale.x)),
-			std::ceil(static_cast<float>(Renderable.Sprite.Height * Renderable.Transform.Scale.y))
+			std::round(static_cast<float>(Position.x - (Sprite.IsFixed ? 0.0f : Camera.x))),
+			std::round(static_cast<float>(Position.y - (Sprite.IsFixed ? 0.0f : Camera.y))),
+			std::ceil(static_cast<float>(Sprite.Width * Transform.Scale.x)),
+			std::ceil(static_cast<float>(Sprite.Height * Transform.Scale.y))
 		};
 
-		SDL_RenderTextureRotated
-		(
-			Context.Renderer,
-			Context.Assets->GetTexture(Renderable.Sprite.AssetID),
-			&SourceRectangle,
-			&DestinationRectangle,
-			Renderable.Transform.Rotation,
-			nullptr,
-			Renderable.Sprite.Flip
-		);
+		// SrcRect stays relative to the sprite's own image; the atlas offset is applied here.
+		const SDL_FRect SourceRectangle = { Region.Rect.x + Sprite.SrcRect.x, Region.Rect.y + Sprite.SrcRect.y, Sprite.SrcRect.w, Sprite.SrcRect.h };
+		Batch.Add(Region.Texture, Sprite.ZIndex, SourceRectangle, DestinationRectangle, Transform.Rotation, Sprite.Flip);
+	});
+
+	Batch.Flush(Render.GetRecordingList());
+}
+
+static void RenderSpriteSystemTask(flecs::iter& Iter, size_t)
+{
+	RecordSprites(Iter.world(), SpriteSpace::World);
+}
+
+// Fixed sprites are HUD elements, so they are drawn after the world is upscaled, above every
+// world sprite regardless of z-index.
+static void RenderScreenSpriteSystemTask(flecs::iter& Iter, size_t)
+{
+	RecordSprites(Iter.world(), SpriteSpace::Screen);
+}
+
+// Particles are drawn above the world's sprites, one draw call per texture.
+static void RenderParticleSystemTask(flecs::iter& Iter, size_t)
+{
+	auto World = Iter.world();
+	auto& Context = World.get_mut<GameContext>();
+	if (!Context.Renderer || !Context.Assets)
+	{
+		return;
+	}
+
+	auto& Render = World.get_mut<RenderState>();
+	auto& Commands = Render.GetRecordingList();
+	for (const ParticleSystem::TexturePool& Entry : World.get<ParticleState>().Particles.GetPools())
+	{
+		const TextureRegion& Region = Context.Assets->GetTextureRegion(Entry.Texture);
+		float TextureWidth = 0.0f;
+		float TextureHeight = 0.0f;
+		if (Entry.Pool.GetCount() == 0 || !Region.Texture || !SDL_GetTextureSize(Region.Texture, &TextureWidth, &TextureHeight))
+		{
+			continue;
+		}
+
+		const SDL_FRect UV = { Region.Rect.x / TextureWidth, Region.Rect.y / TextureHeight, Region.Rect.w / TextureWidth, Region.Rect.h / TextureHeight };
+		Render.ParticleVertices.clear();
+		const size_t QuadCount = Entry.Pool.AppendVertices(Render.Camera, UV, Render.ParticleVertices);
+		Commands.DrawQuads(Region.Texture, Render.ParticleVertices.data(), QuadCount);
 	}
 }
 
+// Only tables whose labels were modified since the last frame are visited. Labels whose text did
+// not actually change get the same cache entry back without being rasterized again.
+static void TextLabelCacheSystemTask(flecs::iter& Iter)
+{
+	auto World = Iter.world();
+	auto& Context = World.get_mut<GameContext>();
+	auto& Render = World.get_mut<RenderState>();
+
+	// Releasing can evict and destroy textures, which is only safe here: on the renderer's thread,
+	// after the list that drew these labels has been presented and before this frame records any.
+	for (const flecs::entity_t Entity : Render.RemovedLabels)
+	{
+		const auto LabelTexture = Render.LabelTextures.find(Entity);
+		if (LabelTexture != Render.LabelTextures.end())
+		{
+			Render.Text.Release(LabelTexture->second);
+			Render.LabelTextures.erase(LabelTexture);
+		}
+	}
+	Render.RemovedLabels.clear();
+
+	while (Iter.next())
+	{
+		if (!Iter.changed() || !Context.Renderer || !Context.Assets)
+		{
+			continue;
+		}
+
+		auto TextLabels = Iter.field<const TextLabelComponent>(0);
+		for (auto Row : Iter)
+		{
+			const TextLabelComponent& TextLabel = TextLabels[Row];
+			TextCache::Entry* CachedText = Render.Text.Acquire(Context.Renderer, Context.Assets->GetFont(TextLabel.AssetID), TextLabel.AssetID, TextLabel.Text, TextLabel.Color);
+
+			TextCache::Entry*& LabelTexture = Render.LabelTextures[Iter.entity(Row).id()];
+			Render.Text.Release(LabelTexture);
+			LabelTexture = CachedText;
+		}
+	}
+}
+
+// Runs on the simulation thread when labelled entities are destroyed, so it only queues the release.
+static void TextLabelRemoveObserverTask(flecs::iter& Iter, size_t Row, const TextLabelComponent&)
+{
+	auto World = Iter.world();
+	World.get_mut<RenderState>().RemovedLabels.push_back(Iter.entity(Row).id());
+}
+
 static void RenderTextSystemTask(flecs::iter& Iter, size_t)
 {
 	auto World = Iter.world();
 	auto& Context = World.get_mut<GameContext>();
-	if (!Context.Renderer || !Context.Assets || !Context.Camera)
+	if (!Context.Renderer || !Context.Camera)
 	{
 		return;
 	}
 
-	const SDL_FRect& Camera = *Context.Camera;
-	World.each([&Context, &Camera](const TextLabelComponent& TextLabel)
+	auto& Render = World.get_mut<RenderState>();
+	const SDL_FRect& Camera = Render.Camera;
+	auto& Commands = Render.GetRecordingList();
+	World.each([&Camera, &Render, &Commands](flecs::entity Entity, const TextLabelComponent& TextLabel)
 	{
-		SDL_Surface* TextSurface = TTF_RenderText_Blended(Context.Assets->GetFont(TextLabel.AssetID), TextLabel.Text.c_str(), 0, TextLabel.Color);
-		SDL_Texture* TextTexture = SDL_CreateTextureFromSurface(Context.Renderer, TextSurface);
-		SDL_DestroySurface(TextSurface);
+		const auto LabelTexture = Render.LabelTextures.find(Entity.id());
+		if (LabelTexture == Render.LabelTextures.end() || !LabelTexture->second->Texture)
+		{
+			return;
+		}
 
-		float LabelWidth = 0.0f;
-		float LabelHeight = 0.0f;
-		SDL_GetTextureSize(TextTexture, &LabelWidth, &LabelHeight);
+		const TextCache::Entry& CachedText = *LabelTexture->second;
 		SDL_FRect DestinationRectangle =
 		{
 			static_cast<float>(TextLabel.Position.x - (TextLabel.IsFixed ? 0.0f : Camera.x)),
 			static_cast<float>(TextLabel.Position.y - (TextLabel.IsFixed ? 0.0f : Camera.y)),
-			LabelWidth,
-			LabelHeight
+			CachedText.Width,
+			CachedText.Height
 		};
 
-		SDL_RenderTexture(Context.Renderer, TextTexture, nullptr, &DestinationRectangle);
-		SDL_DestroyTexture(TextTexture);
+		Commands.DrawTexture(CachedText.Texture, DestinationRectangle);
 	});
 }
 
+static constexpr float HealthBarCullPadding = 32.0f;
+
 static void RenderHealthBarSystemTask(flecs::iter& Iter, size_t)
 {
 	auto World = Iter.world();
@@ -134,27 +379,45 @@ static void RenderHealthBarSystemTask(flecs::iter& Iter, size_t)
 		return;
 	}
 
-	const SDL_FRect& Camera = *Context.Camera;
-	World.each([&Context, &Camera](const TransformComponent& Transform, const HealthComponent& Health, const SpriteComponent& Sprite)
+	const GlyphAtlas* Glyphs = Context.Assets->GetGlyphAtlas(Context.Renderer, "pico8-font-5");
+	auto& Render = World.get_mut<RenderState>();
+	const SDL_FRect& Camera = Render.Camera;
+	const float Alpha = Render.InterpolationAlpha;
+	auto& Batch = Render.HealthBars;
+	Batch.Begin();
+
+	// Bars go in one untextured draw call and every label in one call on the glyph atlas. The bar
+	// and its label hang off the sprite's right edge, hence the padding around the camera.
+	ForEachVisibleSprite(Render, Camera, HealthBarCullPadding, SpriteSpace::World | SpriteSpace::Screen, [&World, Glyphs, &Camera, Alpha, &Batch](flecs::entity_t EntityID)
 	{
-		SDL_Color HealthBarColor = { 255, 255, 255 };
+		const flecs::entity Entity(World, EntityID);
+		if (!Entity.has<HealthComponent>())
+		{
+			return;
+		}
+
+		const TransformComponent& Transform = Entity.get<TransformComponent>();
+		const SpriteComponent& Sprite = Entity.get<SpriteComponent>();
+		const HealthComponent& Health = Entity.get<HealthComponent>();
+		SDL_FColor HealthBarColor = { 1.0f, 1.0f, 1.0f, 1.0f };
 		if (Health.HealthPercentage < 40)
 		{
-			HealthBarColor = { 255, 0, 0 };
+			HealthBarColor = { 1.0f, 0.0f, 0.0f, 1.0f };
 		}
 		else if (Health.HealthPercentage < 80)
 		{
-			HealthBarColor = { 255, 255, 0 };
+			HealthBarColor = { 1.0f, 1.0f, 0.0f, 1.0f };
 		}
 		else
 		{
-			HealthBarColor = { 0, 255, 0 };
+			HealthBarColor = { 0.0f, 1.0f, 0.0f, 1.0f };
 		}
 
 		const float HealthBarWidth = 15.0f;
 		const float HealthBarHeight = 3.0f;
-		const float HealthBarPositionX = Transform.Position.x + (Sprite.Width * Transform.Scale.x) - Camera.x;
-		const float HealthBarPositionY = Transform.Position.y - Camera.y;
+		const glm::vec2 Position = GetRenderPosition(Entity, Transform, Alpha);
+		const float HealthBarPositionX = Position.x + (Sprite.Width * Transform.Scale.x) - Camera.x;
+		const float HealthBarPositionY = Position.y - Camera.y;
 		SDL_FRect HealthBarRect =
 		{
 			HealthBarPositionX,
@@ -162,55 +425,70 @@ static void RenderHealthBarSystemTask(flecs::iter& Iter, size_t)
 			HealthBarWidth * (Health.HealthPercentage / 100.0f),
 			HealthBarHeight
 		};
+		Batch.AddRect(0, HealthBarRect, HealthBarColor);
 
-		SDL_SetRenderDrawColor(Context.Renderer, HealthBarColor.r, HealthBarColor.g, HealthBarColor.b, 255);
-		SDL_RenderFillRect(Context.Renderer, &HealthBarRect);
-
-		const std::string HealthText = std::to_string(Health.HealthPercentage) + "%";
-		SDL_Surface* TextSurface = TTF_RenderText_Blended(Context.Assets->GetFont("pico8-font-5"), HealthText.c_str(), 0, HealthBarColor);
-		SDL_Texture* TextTexture = SDL_CreateTextureFromSurface(Context.Renderer, TextSurface);
-		SDL_DestroySurface(TextSurface);
-
-		float LabelWidth = 0.0f;
-		float LabelHeight = 0.0f;
-		SDL_GetTextureSize(TextTexture, &LabelWidth, &LabelHeight);
-		SDL_FRect HealthBarTextRectangle = { HealthBarPositionX, HealthBarPositionY + 5.0f, LabelWidth, LabelHeight };
-		SDL_RenderTexture(Context.Renderer, TextTexture, nullptr, &HealthBarTextRectangle);
-		SDL_DestroyTexture(TextTexture);
+		if (Glyphs)
+		{
+			char HealthText[8];
+			char* TextEnd = std::to_chars(HealthText, HealthText + sizeof(HealthText) - 1, Health.HealthPercentage).ptr;
+			*TextEnd++ = '%';
+			Glyphs->AddText(Batch, std::string_view(HealthText, static_cast<size_t>(TextEnd - HealthText)), HealthBarPositionX, HealthBarPositionY + 5.0f, HealthBarColor, 1);
+		}
 	});
+
+	Batch.Flush(Render.GetRecordingList());
 }
 
+// The list recorded this frame becomes the one the game presents, and the other one is recorded
+// into next frame.
 static void RenderEndSystemTask(flecs::iter& Iter, size_t)
 {
 	auto World = Iter.world();
-	auto& Context = World.get_mut<GameContext>();
-	if (Context.Renderer)
+	World.get_mut<RenderState>().SwapCommandLists();
+}
+
+// Calls OnVisible(Bounds) for every collider overlapping the camera, using whichever broadphase
+// structure is current: the persistent trees, or the grid rebuilt this frame.
+template <typename Callback>
+static void ForEachVisibleCollider(const CollisionState& Collision, const SDL_FRect& Camera, Callback&& OnVisible)
+{
+	const AABB CameraBounds(Camera.x, Camera.y, Camera.x + Camera.w, Camera.y + Camera.h);
+	if (Collision.Broadphase == BroadphaseMode::SpatialHash)
 	{
-		SDL_RenderPresent(Context.Renderer);
+		Collision.Grid.Query(CameraBounds, Collision.ColliderBounds, CollisionLayer::All, [&Collision, &OnVisible](uint32_t Index)
+		{
+			OnVisible(Collision.ColliderBounds[Index]);
+		});
+		return;
+	}
+
+	for (const AABBTree* Tree : { &Collision.DynamicTree, &Collision.StaticTree })
+	{
+		Tree->Query(CameraBounds, CollisionLayer::All, [Tree, &CameraBounds, &OnVisible](int32_t Proxy)
+		{
+			if (Tree->GetBounds(Proxy).Overlaps(CameraBounds))
+			{
+				OnVisible(Tree->GetBounds(Proxy));
+			}
+		});
 	}
 }
 
 static void RunRenderDebugSystem(flecs::world World)
 {
 	auto& Context = World.get_mut<GameContext>();
-	if (!Context.Renderer || !Context.Camera || !Context.IsDebug || !*Context.IsDebug)
+	if (!Context.Renderer || !Context.Assets || !Context.Camera || !Context.IsDebug || !*Context.IsDebug)
 	{
 		return;
 	}
 
-	const SDL_FRect& Camera = *Context.Camera;
-	World.each([&Context, &Camera](const TransformComponent& Transform, const BoxColliderComponent& Collider)
+	auto& Render = World.get_mut<RenderState>();
+	const SDL_FRect& Camera = Render.Camera;
+	auto& Commands = Render.GetRecordingList();
+	ForEachVisibleCollider(World.get<CollisionState>(), Camera, [&Camera, &Commands](const AABB& Bounds)
 	{
-		SDL_FRect ColliderRect =
-		{
-			static_cast<float>(Transform.Position.x + Collider.Offset.x - Camera.x),
-			static_cast<float>(Transform.Position.y + Collider.Offset.y - Camera.y),
-			static_cast<float>(Collider.Width * Transform.Scale.x),
-			static_cast<float>(Collider.Height * Transform.Scale.y)
-		};
-
-		SDL_SetRenderDrawColor(Context.Renderer, 255, 0, 0, 255);
-		SDL_RenderRect(Context.Renderer, &ColliderRect);
+		const SDL_FRect ColliderRect = { Bounds.MinX - Camera.x, Bounds.MinY - Camera.y, Bounds.MaxX - Bounds.MinX, Bounds.MaxY - Bounds.MinY };
+		Commands.DrawRectOutline(ColliderRect, { 255, 0, 0, 255 });
 	});
 
 	ImGui_ImplSDLRenderer3_NewFrame();
@@ -278,11 +556,12 @@ static void RunRenderDebugSystem(flecs::world World)
 		if (ImGui::Button("Spawn enemy"))
 		{
 			auto Enemy = World.entity();
+			Enemy.add<LevelEntityTag>();
 			Enemy.add<EnemiesTag>();
 			Enemy.set<TransformComponent>(TransformComponent(glm::vec2(PositionX, PositionY), glm::vec2(ScaleX, ScaleY), glm::degrees(Rotation)));
 			Enemy.set<RigidBodyComponent>(RigidBodyComponent(glm::vec2(VelocityX, VelocityY)));
-			Enemy.set<SpriteComponent>(SpriteComponent(Sprites[SelectedSpriteIndex], 32, 32, 1));
-			Enemy.set<BoxColliderComponent>(BoxColliderComponent(25, 20, glm::vec2(5, 5)));
+			Enemy.set<SpriteComponent>(SpriteComponent(Context.Assets->GetTextureHandle(Sprites[SelectedSpriteIndex]), 32, 32, 1));
+			Enemy.set<BoxColliderComponent>(BoxColliderComponent(25, 20, glm::vec2(5, 5), CollisionLayer::Enemies));
 
 			const double ProjectileVelocityX = ProjectileSpeed * std::cos(ProjectileAngle);
 			const double ProjectileVelocityY = ProjectileSpeed * std::sin(ProjectileAngle);
@@ -309,11 +588,46 @@ static void RunRenderDebugSystem(flecs::world World)
 	if (ImGui::Begin("Map coordinates", nullptr, WindowFlags))
 	{
 		ImGui::Text("Map coordinates: (x=%.1f, y=%.1f)", ImGui::GetIO().MousePos.x + Camera.x, ImGui::GetIO().MousePos.y + Camera.y);
+		ImGui::Text("Render scale: %.0f%%", Render.RenderScale * 100.0f);
+		const auto& Projectiles = World.get<ProjectilePoolState>();
+		ImGui::Text("Projectile pool: %u / %u active, peak %u", Projectiles.ActiveCount, Projectiles.Capacity, Projectiles.HighWaterMark);
+	}
+	ImGui::End();
+
+	if (ImGui::Begin("Resident Assets"))
+	{
+		// Region sizes do not add up to the page total: free space on a page stays resident too.
+		ImGui::Text("Atlas pages: %.1f MB", static_cast<double>(Context.Assets->GetAtlasPageBytes()) / (1024.0 * 1024.0));
+		if (Context.Assets->HasLazyTextures())
+		{
+			ImGui::Text("Resident textures: %.1f / %.1f MB", static_cast<double>(Context.Assets->GetResidentTextureBytes()) / (1024.0 * 1024.0), static_cast<double>(Context.Assets->GetTextureBudget()) / (1024.0 * 1024.0));
+		}
+		if (ImGui::BeginTable("Assets", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit, ImVec2(0.0f, 300.0f)))
+		{
+			ImGui::TableSetupColumn("Asset");
+			ImGui::TableSetupColumn("Type");
+			ImGui::TableSetupColumn("Refs");
+			ImGui::TableSetupColumn("KB");
+			ImGui::TableHeadersRow();
+			for (const auto& [AssetID, Record] : Context.Assets->GetAssetRecords())
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(AssetID.c_str());
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(Record.Type == AssetType::Font ? "font" : Record.AtlasPage >= 0 ? "atlas" : "texture");
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", Record.RefCount);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", static_cast<double>(Record.ResidentBytes) / 1024.0);
+			}
+			ImGui::EndTable();
+		}
 	}
 	ImGui::End();
 
 	ImGui::Render();
-	ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), Context.Renderer);
+	Commands.SetDrawsDebugUi(true);
 }
 
 static void RenderDebugSystemTask(flecs::iter& Iter, size_t)
@@ -327,10 +641,55 @@ void RegisterRenderSystems(flecs::world& World)
 		.kind(World.lookup(RenderBeginPhaseName).id())
 		.each(RenderBeginSystemTask);
 
+	// Registered before the sprite system so the map is drawn underneath every sprite.
+	World.system("RenderTilemapSystem")
+		.kind(World.lookup(RenderWorldPhaseName).id())
+		.each(RenderTilemapSystemTask);
+
+	World.observer<const TransformComponent, const SpriteComponent>("SpriteProxySetObserver")
+		.event(flecs::OnSet)
+		.each(SpriteProxySetObserverTask);
+
+	World.observer<const TransformComponent, const SpriteComponent>("SpriteProxyRemoveObserver")
+		.event(flecs::OnRemove)
+		.each(SpriteProxyRemoveObserverTask);
+
+	World.system<const TransformComponent, const SpriteComponent, const SpriteProxyComponent>("SpriteProxyRefitSystem")
+		.with<RigidBodyComponent>()
+		.kind(World.lookup(RenderBeginPhaseName).id())
+		.each(SpriteProxyRefitSystemTask);
+
+	// Registered after the refit, so the prefetch sees where sprites are this frame.
+	World.system("TexturePrefetchSystem")
+		.kind(World.lookup(RenderBeginPhaseName).id())
+		.each(TexturePrefetchSystemTask);
+
 	World.system("RenderSpriteSystem")
 		.kind(World.lookup(RenderWorldPhaseName).id())
 		.each(RenderSpriteSystemTask);
 
+	World.system("RenderParticleSystem")
+		.kind(World.lookup(RenderWorldPhaseName).id())
+		.each(RenderParticleSystemTask);
+
+	// Registered first in the UI phase, so every UI system after it draws at native resolution.
+	World.system("RenderWorldResolveSystem")
+		.kind(World.lookup(RenderUiPhaseName).id())
+		.each(RenderWorldResolveSystemTask);
+
+	World.system("RenderScreenSpriteSystem")
+		.kind(World.lookup(RenderUiPhaseName).id())
+		.each(RenderScreenSpriteSystemTask);
+
+	World.observer<const TextLabelComponent>("TextLabelRemoveObserver")
+		.event(flecs::OnRemove)
+		.each(TextLabelRemoveObserverTask);
+
+	World.system<const TextLabelComponent>("TextLabelCacheSystem")
+		.kind(World.lookup(RenderUiPhaseName).id())
+		.detect_changes()
+		.run(TextLabelCacheSystemTask);
+
 	World.system("RenderTextSystem")
 		.kind(World.lookup(RenderUiPhaseName).id())
 		.each(RenderTextSystemTask);
@@ -1,5 +1,7 @@
 #include "FlecsSystems.hpp"
+#include "../Audio/AudioMixer.hpp"
 #include "../Components/AnimationComponent.hpp"
+#include "../Components/CollisionScriptComponent.hpp"
 #include "../Components/ProjectileEmitterComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/ScriptComponent.hpp"
@@ -9,6 +11,7 @@
 #include <glm/glm.hpp>
 
 #include <cstdint>
+#include <string>
 #include <tuple>
 
 static std::tuple<double, double> GetEntityPosition(ScriptEntity ScriptEntity)
@@ -107,6 +110,25 @@ static void SetProjectileVelocity(ScriptEntity ScriptEntity, double X, double Y)
 	SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Entity does not have a ProjectileEmitterComponent.");
 }
 
+// Options: volume, priority, loop, and x/y to place the sound in the world relative to the camera.
+static bool PlaySound(flecs::world& World, const std::string& AssetID, sol::optional<sol::table> Options)
+{
+	SoundParams Params;
+	if (Options)
+	{
+		const sol::table& Table = *Options;
+		Params.Volume = Table["volume"].get_or(Params.Volume);
+		Params.Priority = Table["priority"].get_or(Params.Priority);
+		Params.IsLooping = Table["loop"].get_or(Params.IsLooping);
+		const sol::optional<float> X = Table["x"];
+		const sol::optional<float> Y = Table["y"];
+		Params.IsPositional = X && Y;
+		Params.X = X.value_or(0.0f);
+		Params.Y = Y.value_or(0.0f);
+	}
+	return World.get<GameContext>().Audio->Play(AssetID, Params);
+}
+
 static void ScriptSystemTask(flecs::iter& Iter, size_t Row, const ScriptComponent& Script)
 {
 	if (Script.Funct.valid())
@@ -119,6 +141,7 @@ static void ScriptSystemTask(flecs::iter& Iter, size_t Row, const ScriptComponen
 void RegisterScriptComponents(flecs::world& World)
 {
 	World.component<ScriptComponent>("ScriptComponent");
+	World.component<CollisionScriptComponent>("CollisionScriptComponent");
 }
 
 void RegisterScriptSystems(flecs::world& World)
@@ -129,7 +152,7 @@ void RegisterScriptSystems(flecs::world& World)
 		.each(ScriptSystemTask);
 }
 
-void RegisterScriptBindings(flecs::world&, sol::state& LuaState)
+void RegisterScriptBindings(flecs::world& World, sol::state& LuaState)
 {
 	LuaState.new_usertype<ScriptEntity>
 	(
@@ -147,4 +170,8 @@ void RegisterScriptBindings(flecs::world&, sol::state& LuaState)
 	LuaState.set_function("set_rotation", SetEntityRotation);
 	LuaState.set_function("set_projectile_velocity", SetProjectileVelocity);
 	LuaState.set_function("set_animation_frame", SetEntityAnimationFrame);
+	LuaState.set_function("play_sound", [&World](const std::string& AssetID, sol::optional<sol::table> Options)
+	{
+		return PlaySound(World, AssetID, Options);
+	});
 }
@@ -24,7 +24,11 @@ void RegisterKeyboardControlSystems(flecs::world& World);
 void RegisterMovementSystems(flecs::world& World);
 void RegisterProjectileSystems(flecs::world& World);
 void RegisterAnimationSystems(flecs::world& World);
+void RegisterParticleSystems(flecs::world& World);
 void RegisterCollisionSystems(flecs::world& World);
 void RegisterCameraSystems(flecs::world& World);
 void RegisterRenderSystems(flecs::world& World);
 void RegisterCleanupSystems(flecs::world& World);
+
+// Hands the projectiles in ProjectilePoolState::PendingRelease back to the pool.
+void ReleasePendingProjectiles(flecs::world& World);
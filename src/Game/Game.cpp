@@ -4,6 +4,8 @@
 #include <SDL3_image/SDL_image.h>
 #include <spdlog/spdlog.h>
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_sdl3.h>
@@ -20,6 +22,8 @@ Game::Game()
 	: Window(nullptr), Renderer(nullptr), Camera{ 0.0f, 0.0f, 0.0f, 0.0f }, IsRunning(false), IsDebug(false)
 {
 	GameAssetManager = std::make_unique<AssetManager>();
+	GameTilemap = std::make_unique<Tilemap>();
+	GameAudio = std::make_unique<AudioMixer>();
 	spdlog::info("Game is running.");
 }
 
@@ -28,9 +32,11 @@ Game::~Game()
 	spdlog::info("Game is closing.");
 }
 
-void Game::Initialize()
+void Game::Initialize(const GameOptions& Options)
 {
-	if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO))
+	this->Options = Options;
+	this->Options.TickRate = Options.TickRate > 0 ? Options.TickRate : SIMULATION_TICK_RATE;
+	if (!SDL_Init(Options.IsHeadless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO | SDL_INIT_AUDIO))
 	{
 		spdlog::error("Error initializing SDL.");
 		return;
@@ -42,6 +48,25 @@ void Game::Initialize()
 		return;
 	}
 
+	if (Options.IsHeadless)
+	{
+		// No display and no GPU: draw into a plain surface with the software renderer.
+		WindowWidth = HEADLESS_WIDTH;
+		WindowHeight = HEADLESS_HEIGHT;
+		HeadlessTarget = SDL_CreateSurface(WindowWidth, WindowHeight, SDL_PIXELFORMAT_RGBA8888);
+		Renderer = HeadlessTarget ? SDL_CreateSoftwareRenderer(HeadlessTarget) : nullptr;
+		if (!Renderer)
+		{
+			spdlog::error("Error creating headless software renderer: {}", SDL_GetError());
+			return;
+		}
+
+		Camera = { 0.0f, 0.0f, static_cast<float>(WindowWidth), static_cast<float>(WindowHeight) };
+		IsRunning = true;
+		spdlog::info("Running headless at {}x{}", WindowWidth, WindowHeight);
+		return;
+	}
+
 	const SDL_DisplayMode* DisplayMode = SDL_GetCurrentDisplayMode(SDL_GetPrimaryDisplay());
 	if (DisplayMode && DisplayMode->w > 0)
 	{
@@ -80,6 +105,24 @@ void Game::Initialize()
 		SDL_SetRenderVSync(Renderer, 1);
 	}
 
+	if (DYNAMIC_RESOLUTION)
+	{
+		// Native-sized, so any scale fits; only its top-left corner is drawn into below full scale.
+		WorldTarget = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WindowWidth, WindowHeight);
+		if (WorldTarget)
+		{
+			SDL_SetTextureScaleMode(WorldTarget, SDL_SCALEMODE_LINEAR);
+			SDL_SetTextureBlendMode(WorldTarget, SDL_BLENDMODE_NONE);
+		}
+		else
+		{
+			spdlog::warn("Error creating world render target, rendering at native resolution: {}", SDL_GetError());
+		}
+	}
+
+	// Headless runs never initialize audio, so their mixer stays closed and every sound is skipped.
+	GameAudio->Open();
+
 	// Initialize Dear ImGui
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
@@ -90,17 +133,37 @@ void Game::Initialize()
 	Camera = { 0.0f, 0.0f, static_cast<float>(WindowWidth), static_cast<float>(WindowHeight) };
 
 	SDL_SetWindowFullscreen(Window, true);
+	UpdateFrameBudget();
 	IsRunning = true;
 }
 
+// Frame times include the wait for VSync in SDL_RenderPresent, so a frame is never shorter than the
+// display's refresh interval; budgeting for FPS instead would pin the scale down below 60 Hz.
+void Game::UpdateFrameBudget()
+{
+	double BudgetMilliseconds = 1000.0 / FPS;
+	const SDL_DisplayMode* DisplayMode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(Window));
+	if (VSYNC && DisplayMode && DisplayMode->refresh_rate > 0.0f)
+	{
+		BudgetMilliseconds = 1000.0 / DisplayMode->refresh_rate;
+	}
+	WorldScaler.SetBudget(BudgetMilliseconds);
+	spdlog::info("Frame budget is {:.2f} ms", BudgetMilliseconds);
+}
+
 void Game::ProcessInput()
 {
 	auto& Input = GameWorld.get_mut<InputState>();
-	Input.Clear();
 
 	SDL_Event Event;
 	while (SDL_PollEvent(&Event))
 	{
+		if (Options.IsHeadless)
+		{
+			Input.QuitRequested = Input.QuitRequested || Event.type == SDL_EVENT_QUIT;
+			continue;
+		}
+
 		// Handle ImGui events
 		ImGui_ImplSDL3_ProcessEvent(&Event);
 		ImGuiIO& DebugIO = ImGui::GetIO();
@@ -118,6 +181,15 @@ void Game::ProcessInput()
 		case SDL_EVENT_QUIT:
 			Input.QuitRequested = true;
 			break;
+		case SDL_EVENT_RENDER_TARGETS_RESET:
+			GameTilemap->Rebake(Renderer);
+			break;
+		case SDL_EVENT_RENDER_DEVICE_RESET:
+			GameTilemap->Recreate(Renderer);
+			break;
+		case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+			UpdateFrameBudget();
+			break;
 		case SDL_EVENT_KEY_DOWN:
 			Input.PressedKeys.push_back(Event.key.key);
 			if (Event.key.key == SDLK_ESCAPE)
@@ -128,6 +200,10 @@ void Game::ProcessInput()
 			{
 				Input.ToggleDebugRequested = true;
 			}
+			if (Event.key.key >= SDLK_1 && Event.key.key <= SDLK_9)
+			{
+				RequestedLevel = static_cast<uint8_t>(Event.key.key - SDLK_0);
+			}
 			break;
 		}
 	}
@@ -138,54 +214,262 @@ void Game::Setup()
 	LuaState.open_libraries(sol::lib::base, sol::lib::math, sol::lib::os);
 
 	RegisterFlecsGameWorld(GameWorld);
-	GameWorld.set<GameContext>(GameContext{ Renderer, GameAssetManager.get(), &Camera, &IsDebug, &IsRunning });
+	GameWorld.set<GameContext>(GameContext{ Renderer, GameAssetManager.get(), &Camera, &IsDebug, &IsRunning, GameTilemap.get(), GameAudio.get() });
 	GameWorld.set<InputState>(InputState{});
 	GameWorld.set<MapBounds>(MapBounds{});
 	GameWorld.set<CollisionState>(CollisionState{});
+	GameWorld.set<CollisionWorkerState>(CollisionWorkerState{});
+	GameWorld.set<RenderState>(RenderState{});
+	GameWorld.set<ParticleState>(ParticleState{});
+	GameWorld.set<ProjectilePoolState>(ProjectilePoolState{});
+	GameWorld.get_mut<RenderState>().Text.SetBudget(TEXT_CACHE_BUDGET_BYTES);
+	if (LAZY_TEXTURES)
+	{
+		GameAssetManager->EnableLazyTextures(Renderer, TEXTURE_BUDGET_BYTES, TEXTURE_PREFETCH_RADIUS);
+	}
 
 	RegisterScriptBindings(GameWorld, LuaState);
 	RegisterFlecsSystems(GameWorld);
+	Pipelines = CreateFramePipelines(GameWorld);
+
+	// Worker threads only pick up systems marked multi_threaded, such as collision detection.
+	const int WorkerThreads = std::clamp(SDL_GetNumLogicalCPUCores(), 1, MAX_WORKER_THREADS);
+	GameWorld.set_threads(WorkerThreads);
+	spdlog::info("Running flecs with {} worker threads", WorkerThreads);
 
+	LoadLevel(2);
+}
+
+void Game::LoadLevel(uint8_t LevelNumber)
+{
 	LevelLoader Loader;
-	Loader.LoadLevel(LuaState, GameWorld, GameAssetManager, Renderer, 2);
+	Loader.LoadLevel(LuaState, GameWorld, GameAssetManager, GameTilemap, Renderer, LevelNumber);
 }
 
 void Game::Update()
 {
 	// If we are too fast, wait until the next frame (skip when VSync handles pacing)
-	if (CAP_FRAMES && !VSYNC)
+	if (CAP_FRAMES && !VSYNC && !Options.IsHeadless)
+	{
+		const uint64_t ElapsedNS = SDL_GetTicksNS() - PreviousFrameNS;
+		if (ElapsedNS < NANOSECONDS_PER_FRAME)
+		{
+			SDL_DelayNS(NANOSECONDS_PER_FRAME - ElapsedNS);
+		}
+	}
+
+	const uint64_t TickNS = 1'000'000'000 / Options.TickRate;
+	const uint64_t NowNS = SDL_GetTicksNS();
+	// Headless runs advance exactly one tick per frame, so their timings compare between machines.
+	const uint64_t FrameNS = Options.IsHeadless ? TickNS : NowNS - PreviousFrameNS;
+	PreviousFrameNS = NowNS;
+
+	TickAccumulatorNS += (std::min)(FrameNS, TickNS * MAX_TICKS_PER_FRAME);
+	const uint32_t Ticks = static_cast<uint32_t>(TickAccumulatorNS / TickNS);
+	TickAccumulatorNS -= Ticks * TickNS;
+
+	// This frame's ticks are simulated on the simulation thread while the previous frame's commands
+	// are submitted here, so waiting for VSync in SDL_RenderPresent overlaps with gameplay work.
+	GrowProjectilePool(GameWorld);
+	const RenderCommandList& PresentList = GameWorld.get<RenderState>().GetPresentList();
+	BeginSimulation(Ticks, static_cast<float>(TickNS) / 1'000'000'000.0f);
+	PresentFrame(PresentList);
+	WaitForSimulation();
+
+	// Neither pipeline is running and the last frame that drew the old level has been presented.
+	if (RequestedLevel != 0)
+	{
+		LoadLevel(RequestedLevel);
+		RequestedLevel = 0;
+		// Loading is not gameplay time, so the next frame does not try to catch up on it.
+		PreviousFrameNS = SDL_GetTicksNS();
+	}
+	GameAudio->SetListener(Camera.x + Camera.w * 0.5f, Camera.y + Camera.h * 0.5f);
+
+	// The leftover time in the accumulator says how far the frame is into the next tick.
+	auto& Render = GameWorld.get_mut<RenderState>();
+	const float Alpha = static_cast<float>(TickAccumulatorNS) / static_cast<float>(TickNS);
+	Render.InterpolationAlpha = Alpha;
+	Render.Camera = Camera;
+	Render.Camera.x = PreviousCamera.x + (Camera.x - PreviousCamera.x) * Alpha;
+	Render.Camera.y = PreviousCamera.y + (Camera.y - PreviousCamera.y) * Alpha;
+	Render.WorldTarget = WorldTarget;
+	Render.RenderScale = WorldScaler.GetScale();
+
+	// Recording stays on the main thread: render systems create text and glyph textures, which SDL
+	// only allows on the thread that owns the renderer. Lazy textures are uploaded here for the same reason.
+	GameAssetManager->UpdateTextureResidency();
+	GameWorld.run_pipeline(Pipelines.Render, static_cast<float>(FrameNS) / 1'000'000'000.0f);
+	IsRunning = IsRunning && !GameWorld.should_quit();
+}
+
+void Game::PresentFrame(const RenderCommandList& Commands)
+{
+	if (!Renderer)
+	{
+		return;
+	}
+
+	Commands.Execute(Renderer);
+	if (Commands.DrawsDebugUi())
+	{
+		ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), Renderer);
+	}
+	SDL_RenderPresent(Renderer);
+}
+
+void Game::RunSimulationThread()
+{
+	std::unique_lock<std::mutex> Lock(SimulationMutex);
+	while (true)
 	{
-		uint16_t TimeToWait = MILISECONDS_PER_FRAME - (SDL_GetTicks() - MillisecondsPreviousFrame);
-		if (TimeToWait > 0 && TimeToWait <= MILISECONDS_PER_FRAME)
+		SimulationCondition.wait(Lock, [this]() { return IsSimulationRequested || IsSimulationStopping; });
+		if (IsSimulationStopping)
+		{
+			return;
+		}
+
+		Lock.unlock();
+		for (uint32_t Tick = 0; Tick < SimulationTicks; ++Tick)
 		{
-			SDL_Delay(TimeToWait);
+			PreviousCamera = Camera;
+			GameWorld.run_pipeline(Pipelines.Simulation, SimulationTickSeconds);
+			// Input gathered since the last tick is consumed by the first tick that runs.
+			GameWorld.get_mut<InputState>().Clear();
 		}
+		Lock.lock();
+
+		IsSimulationRequested = false;
+		SimulationCondition.notify_all();
 	}
+}
 
-	// TODO: replace double with std::float64_t when gcc has stable support for C++23
-	double DeltaTime = (SDL_GetTicks() - MillisecondsPreviousFrame) / 1000.0;
+void Game::BeginSimulation(uint32_t Ticks, float TickSeconds)
+{
+	{
+		std::lock_guard<std::mutex> Lock(SimulationMutex);
+		SimulationTicks = Ticks;
+		SimulationTickSeconds = TickSeconds;
+		IsSimulationRequested = true;
+	}
+	SimulationCondition.notify_all();
+}
 
-	MillisecondsPreviousFrame = SDL_GetTicks();
+void Game::WaitForSimulation()
+{
+	std::unique_lock<std::mutex> Lock(SimulationMutex);
+	SimulationCondition.wait(Lock, [this]() { return !IsSimulationRequested; });
+}
 
-	// This line moves the game forward (one tick) and runs all the systems.
-	const bool WorldShouldContinue = GameWorld.progress(static_cast<float>(DeltaTime));
-	IsRunning = IsRunning && WorldShouldContinue;
+void Game::StopSimulationThread()
+{
+	{
+		std::lock_guard<std::mutex> Lock(SimulationMutex);
+		IsSimulationStopping = true;
+	}
+	SimulationCondition.notify_all();
+
+	if (SimulationThread.joinable())
+	{
+		SimulationThread.join();
+	}
+}
+
+void Game::ReportFrameTimings(const std::vector<double>& FrameMilliseconds) const
+{
+	if (FrameMilliseconds.empty())
+	{
+		return;
+	}
+
+	for (size_t Frame = 0; Frame < FrameMilliseconds.size(); ++Frame)
+	{
+		std::printf("frame %zu %.3f ms\n", Frame, FrameMilliseconds[Frame]);
+	}
+
+	std::vector<double> Sorted = FrameMilliseconds;
+	std::sort(Sorted.begin(), Sorted.end());
+	double Total = 0.0;
+	for (const double Milliseconds : Sorted)
+	{
+		Total += Milliseconds;
+	}
+
+	const auto Percentile = [&Sorted](double Fraction)
+	{
+		return Sorted[static_cast<size_t>(Fraction * static_cast<double>(Sorted.size() - 1))];
+	};
+	std::printf
+	(
+		"%zu frames: avg %.3f ms, min %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		Sorted.size(),
+		Total / static_cast<double>(Sorted.size()),
+		Sorted.front(),
+		Percentile(0.5),
+		Percentile(0.95),
+		Percentile(0.99),
+		Sorted.back()
+	);
 }
 
 void Game::Run()
 {
 	Setup();
+	SimulationThread = std::thread(&Game::RunSimulationThread, this);
+	PreviousFrameNS = SDL_GetTicksNS();
+	PreviousCamera = Camera;
+
+	const uint32_t FrameCount = Options.FrameCount > 0 || !Options.IsHeadless ? Options.FrameCount : HEADLESS_DEFAULT_FRAMES;
+	std::vector<double> FrameMilliseconds;
+	FrameMilliseconds.reserve(FrameCount);
 	while (IsRunning)
 	{
+		const uint64_t FrameStart = SDL_GetTicksNS();
 		ProcessInput();
 		Update();
+		const double Milliseconds = static_cast<double>(SDL_GetTicksNS() - FrameStart) / 1'000'000.0;
+
+		if (WorldTarget && WorldScaler.AddFrameTime(Milliseconds))
+		{
+			spdlog::info("Render scale changed to {:.0f}%", WorldScaler.GetScale() * 100.0f);
+		}
+
+		if (FrameCount > 0)
+		{
+			FrameMilliseconds.push_back(Milliseconds);
+			IsRunning = IsRunning && FrameMilliseconds.size() < FrameCount;
+		}
+	}
+	StopSimulationThread();
+
+	if (Options.IsHeadless)
+	{
+		ReportFrameTimings(FrameMilliseconds);
 	}
 }
 
 void Game::Destroy() {
-	ImGui_ImplSDLRenderer3_Shutdown();
-	ImGui_ImplSDL3_Shutdown();
-	ImGui::DestroyContext();
+	if (Window)
+	{
+		ImGui_ImplSDLRenderer3_Shutdown();
+		ImGui_ImplSDL3_Shutdown();
+		ImGui::DestroyContext();
+	}
+
+	// Streamed sounds may read from the asset archives, so the mixer stops before they are unmapped.
+	GameAudio->Close();
+
+	// Chunk and text textures belong to the renderer, so they have to go before it does.
+	GameTilemap->Clear();
+	auto& Render = GameWorld.get_mut<RenderState>();
+	Render.LabelTextures.clear();
+	Render.RemovedLabels.clear();
+	Render.Text.Clear();
+
+	if (WorldTarget)
+	{
+		SDL_DestroyTexture(WorldTarget);
+	}
 
 	if (Renderer)
 	{
@@ -197,5 +481,10 @@ void Game::Destroy() {
 		SDL_DestroyWindow(Window);
 	}
 
+	if (HeadlessTarget)
+	{
+		SDL_DestroySurface(HeadlessTarget);
+	}
+
 	SDL_Quit();
 }
\ No newline at end of file
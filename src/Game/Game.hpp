@@ -1,24 +1,59 @@
 #pragma once
 
 #include "../AssetManager/AssetManager.hpp"
+#include "../Audio/AudioMixer.hpp"
 #include "../ECS/FlecsGameWorld.hpp"
+#include "../Render/ResolutionScaler.hpp"
+#include "../Tilemap/Tilemap.hpp"
 #include <SDL3/SDL.h>
 #include <flecs.h>
 #include <sol/sol.hpp>
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 constexpr uint16_t FPS = 60;
-constexpr uint16_t MILISECONDS_PER_FRAME = 1000 / 60;
+constexpr uint64_t NANOSECONDS_PER_FRAME = 1'000'000'000 / FPS;
+constexpr uint16_t SIMULATION_TICK_RATE = 60;
+// Caps the ticks run in one frame, so a long stall does not snowball into ever longer frames.
+constexpr uint32_t MAX_TICKS_PER_FRAME = 8;
 constexpr bool VSYNC = true;
 constexpr bool CAP_FRAMES = true;
+// Lowers the world's render resolution, down to MIN_RENDER_SCALE, while frames miss their budget.
+constexpr bool DYNAMIC_RESOLUTION = true;
+constexpr float MIN_RENDER_SCALE = 0.5f;
+constexpr int MAX_WORKER_THREADS = 8;
+constexpr size_t TEXT_CACHE_BUDGET_BYTES = 8 * 1024 * 1024;
+// Level textures are decoded and uploaded on first use rather than at load time. Sprites within
+// TEXTURE_PREFETCH_RADIUS pixels of the camera are decoded ahead of time in the background, and
+// textures long unused are evicted while more than TEXTURE_BUDGET_BYTES are resident.
+constexpr bool LAZY_TEXTURES = true;
+constexpr size_t TEXTURE_BUDGET_BYTES = 128 * 1024 * 1024;
+constexpr float TEXTURE_PREFETCH_RADIUS = 256.0f;
+constexpr uint16_t HEADLESS_WIDTH = 1280;
+constexpr uint16_t HEADLESS_HEIGHT = 720;
+constexpr uint32_t HEADLESS_DEFAULT_FRAMES = 1000;
+
+struct GameOptions
+{
+	// Renders into an offscreen surface with the software renderer instead of opening a window,
+	// runs without a frame cap and reports per-frame timings on exit.
+	bool IsHeadless = false;
+	// Stops after this many frames; 0 runs until the game quits.
+	uint32_t FrameCount = 0;
+	// Gameplay phases run at this fixed rate, independently of the frame rate.
+	uint16_t TickRate = SIMULATION_TICK_RATE;
+};
 
 class Game
 {
 public:
 	Game();
 	~Game();
-	void Initialize();
+	void Initialize(const GameOptions& Options = GameOptions());
 	void Run();
 	void Setup();
 	void ProcessInput();
@@ -31,15 +66,45 @@ public:
 	static uint16_t MapHeight;
 
 private:
+	void RunSimulationThread();
+	void BeginSimulation(uint32_t Ticks, float TickSeconds);
+	void WaitForSimulation();
+	void StopSimulationThread();
+	void PresentFrame(const RenderCommandList& Commands);
+	void ReportFrameTimings(const std::vector<double>& FrameMilliseconds) const;
+	void UpdateFrameBudget();
+	void LoadLevel(uint8_t LevelNumber);
+
 	SDL_Window *Window;
 	SDL_Renderer *Renderer;
+	SDL_Surface* HeadlessTarget = nullptr;
+	SDL_Texture* WorldTarget = nullptr;
+	ResolutionScaler WorldScaler = ResolutionScaler(1000.0 / FPS, MIN_RENDER_SCALE);
+	GameOptions Options;
 	SDL_FRect Camera;
 	bool IsRunning;
 	bool IsDebug;
-	uint64_t MillisecondsPreviousFrame = 0;
+	uint64_t PreviousFrameNS = 0;
+	uint64_t TickAccumulatorNS = 0;
+	// Camera at the start of the last tick, for interpolating the view like the bodies in it.
+	SDL_FRect PreviousCamera = { 0.0f, 0.0f, 0.0f, 0.0f };
+	// Set by the number keys; the level is swapped between frames, once nothing is drawing it.
+	uint8_t RequestedLevel = 0;
 
 	sol::state LuaState;
 
 	std::unique_ptr<AssetManager> GameAssetManager;
+	std::unique_ptr<Tilemap> GameTilemap;
+	std::unique_ptr<AudioMixer> GameAudio;
 	flecs::world GameWorld;
+	FramePipelines Pipelines;
+
+	// Each tick is simulated on this thread while the main thread presents the previous frame.
+	std::thread SimulationThread;
+	std::mutex SimulationMutex;
+	std::condition_variable SimulationCondition;
+	bool IsSimulationRequested = false;
+	bool IsSimulationStopping = false;
+	uint32_t SimulationTicks = 0;
+	float SimulationTickSeconds = 0.0f;
 };
@@ -1,10 +1,14 @@
 #include "LevelLoader.hpp"
 #include "Game.hpp"
+#include "../Audio/AudioMixer.hpp"
 #include "../Components/AnimationComponent.hpp"
 #include "../Components/BoxColliderComponent.hpp"
 #include "../Components/CameraFollowComponent.hpp"
+#include "../Components/CollisionScriptComponent.hpp"
 #include "../Components/KeyboardControlComponent.hpp"
 #include "../Components/HealthComponent.hpp"
+#include "../Components/ParticleBurstComponent.hpp"
+#include "../Components/ParticleEmitterComponent.hpp"
 #include "../Components/ProjectileEmitterComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/ScriptComponent.hpp"
@@ -13,10 +17,37 @@
 #include "../Components/TransformComponent.hpp"
 #include "../ECS/FlecsGameWorld.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <filesystem>
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Every field is optional; the color channels are 0-255 like text label colors.
+static ParticleEffect ReadParticleEffect(const sol::table& Table, AssetManager& Assets)
+{
+	ParticleEffect Effect;
+	Effect.Texture = Assets.GetTextureHandle(Table["texture_asset_id"].get_or(std::string("bullet-texture")));
+	Effect.Lifetime = Table["lifetime"].get_or(Effect.Lifetime);
+	Effect.LifetimeVariance = Table["lifetime_variance"].get_or(Effect.LifetimeVariance);
+	Effect.Speed = Table["speed"].get_or(Effect.Speed);
+	Effect.SpeedVariance = Table["speed_variance"].get_or(Effect.SpeedVariance);
+	Effect.Direction = Table["direction"].get_or(Effect.Direction);
+	Effect.Spread = Table["spread"].get_or(Effect.Spread);
+	Effect.Size = Table["size"].get_or(Effect.Size);
+	Effect.Color =
+	{
+		Table["color"]["r"].get_or(255) / 255.0f,
+		Table["color"]["g"].get_or(255) / 255.0f,
+		Table["color"]["b"].get_or(255) / 255.0f,
+		Table["color"]["a"].get_or(255) / 255.0f
+	};
+	Effect.Offset = glm::vec2(Table["offset"]["x"].get_or(0.0), Table["offset"]["y"].get_or(0.0));
+	return Effect;
+}
 
 LevelLoader::LevelLoader()
 {
@@ -28,9 +59,19 @@ LevelLoader::~LevelLoader()
 	spdlog::info("LevelLoader destroyed");
 }
 
-void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std::unique_ptr<AssetManager>& AssetManager, SDL_Renderer* Renderer, uint8_t LevelNumber)
+void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std::unique_ptr<AssetManager>& AssetManager, const std::unique_ptr<Tilemap>& Map, SDL_Renderer* Renderer, uint8_t LevelNumber)
 {
-	sol::load_result Script = LuaState.load_file("./assets/scripts/Level" + std::to_string(LevelNumber) + ".lua");
+	// A packed level maps its textures, fonts and script from one archive built by AssetPacker.
+	// Without one, or for files it does not contain, the loose files are loaded instead.
+	const std::string ArchivePath = "./assets/packs/Level" + std::to_string(LevelNumber) + ".rlpak";
+	if (std::filesystem::exists(ArchivePath))
+	{
+		AssetManager->MountArchive(ArchivePath);
+	}
+
+	const std::string ScriptPath = "./assets/scripts/Level" + std::to_string(LevelNumber) + ".lua";
+	const std::string_view PackedScript = AssetManager->GetPackedFile(ScriptPath);
+	sol::load_result Script = PackedScript.empty() ? LuaState.load_file(ScriptPath) : LuaState.load(PackedScript, "@" + ScriptPath);
 	if (!Script.valid())
 	{
 		sol::error Error = Script;
@@ -39,12 +80,24 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 		return;
 	}
 
-	LuaState.script_file("./assets/scripts/Level" + std::to_string(LevelNumber) + ".lua");
+	Script();
 	spdlog::info("Level {} loaded", LevelNumber);
 
 	sol::table Level = LuaState["Level"];
 
+	// The previous level's entities go first, so none of them refers to an asset released below.
+	DestroyLevelEntities(World);
+
+	// Decoding and file reads run on the loader's workers; the GPU uploads stay on this thread.
+	const uint64_t AssetsStartNS = SDL_GetTicksNS();
+	AssetLoader Loader(std::clamp(SDL_GetNumLogicalCPUCores(), 1, MAX_WORKER_THREADS));
+
 	sol::table Assets = Level["assets"];
+	std::vector<std::pair<std::string, std::string>> TextureFiles;
+	std::vector<FontFile> FontFiles;
+	// Sounds belong to the mixer rather than the asset manager; a new level replaces them all.
+	AudioMixer* Audio = World.get<GameContext>().Audio;
+	Audio->ClearSounds();
 	uint16_t i = 0;
 	while (true)
 	{
@@ -58,17 +111,26 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 		std::string AssetType = Asset["type"];
 		if (AssetType == "texture")
 		{
-			AssetManager->AddTexture(Renderer, Asset["id"], Asset["file"]);
-			spdlog::info("Texture with AssetID {} added to the AssetManager", Asset["id"].get<std::string>());
+			TextureFiles.emplace_back(Asset["id"].get<std::string>(), Asset["file"].get<std::string>());
 		}
 		if (AssetType == "font")
 		{
-			AssetManager->AddFont(Asset["id"], Asset["file"], Asset["font_size"]);
-			spdlog::info("Font with AssetID {} and size {} added to the AssetManager", Asset["id"].get<std::string>(), Asset["font_size"].get<int>());
+			FontFiles.push_back(FontFile{ Asset["id"].get<std::string>(), Asset["file"].get<std::string>(), Asset["font_size"].get<uint8_t>() });
+		}
+		if (AssetType == "sound")
+		{
+			// Long tracks set streamed = true and are decoded while they play instead of all at once.
+			const std::string FilePath = Asset["file"];
+			Audio->AddSound(Asset["id"].get<std::string>(), FilePath, Asset["streamed"].get_or(false), AssetManager->GetPackedFile(FilePath));
 		}
 		i++;
 	}
 
+	// New level textures share a few atlas pages so sprites of different types can be batched together.
+	// Returns once every asset is resident, before any entity below resolves its handles.
+	AssetManager->LoadLevelAssets(Renderer, TextureFiles, FontFiles, Loader);
+	spdlog::info("Level {} assets loaded in {:.2f} ms on {} worker threads", LevelNumber, static_cast<double>(SDL_GetTicksNS() - AssetsStartNS) / 1e6, Loader.GetThreadCount());
+
 	sol::table Tilemap = Level["tilemap"];
 	std::string MapFilePath = Tilemap["map_file"];
 	std::string MapTextureAssetID = Tilemap["texture_asset_id"];
@@ -77,32 +139,56 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 	uint16_t TileSize = Tilemap["tile_size"];
 	double MapScale = Tilemap["scale"];
 
-	std::fstream TilemapFile;
-	TilemapFile.open(MapFilePath, std::ios::in);
-	for (uint16_t y = 0; y < MapNumRows; y++)
+	Map->Load(MapFilePath, MapNumRows, MapNumColumns, TileSize, static_cast<float>(MapScale));
+	Map->Bake(Renderer, *AssetManager, AssetManager->GetTextureHandle(MapTextureAssetID));
+
+	Game::MapWidth = Map->GetWidth();
+	Game::MapHeight = Map->GetHeight();
+	World.set<MapBounds>(MapBounds{ Game::MapWidth, Game::MapHeight });
+
+	sol::optional<sol::table> CollisionConfig = Level["collision"];
+	if (CollisionConfig != sol::nullopt)
 	{
-		for (uint16_t x = 0; x < MapNumColumns; x++)
+		auto& Collision = World.get_mut<CollisionState>();
+		Collision.Grid.SetCellSize(Level["collision"]["cell_size"].get_or(SpatialHashGrid::DefaultCellSize));
+
+		const std::string Broadphase = Level["collision"]["broadphase"].get_or(std::string("grid"));
+		Collision.Broadphase = Broadphase == "tree" ? BroadphaseMode::AABBTree : BroadphaseMode::SpatialHash;
+
+		sol::optional<sol::table> HasInteractions = Level["collision"]["interactions"];
+		if (HasInteractions != sol::nullopt)
 		{
-			char ch;
-			TilemapFile.get(ch);
-            //TODO: This only works for single digit tile indices. Need to update the tilemap file format to support multiple digit indices and update this code to parse them correctly.
-			uint16_t SourceRectangleY = static_cast<uint16_t>((ch - '0') * TileSize);
-			TilemapFile.get(ch);
-            //TODO: This only works for single digit tile indices. Need to update the tilemap file format to support multiple digit indices and update this code to parse them correctly.
-			uint16_t SourceRectangleX = static_cast<uint16_t>((ch - '0') * TileSize);
-			TilemapFile.ignore();
-
-			flecs::entity Tile = World.entity();
-			ApplyGameplayTag(World, Tile, "Tiles");
-			Tile.set<TransformComponent>(TransformComponent(glm::vec2(x * (MapScale * TileSize), y * (MapScale * TileSize)), glm::vec2(MapScale, MapScale), 0.0));
-			Tile.set<SpriteComponent>(SpriteComponent(MapTextureAssetID, TileSize, TileSize, 0, false, SourceRectangleX, SourceRectangleY));
+			sol::table Interactions = Level["collision"]["interactions"];
+			Collision.LayerMatrix.Clear();
+			uint16_t j = 0;
+			while (true)
+			{
+				sol::optional<sol::table> HasInteraction = Interactions[j];
+				if (HasInteraction == sol::nullopt)
+				{
+					break;
+				}
+
+				sol::table Interaction = Interactions[j];
+				const std::string Layer = Interaction["layer"];
+				const std::string CollidesWith = Interaction["collides_with"];
+				const uint32_t LayerBit = GetCollisionLayer(Layer);
+				const uint32_t CollidesWithBit = GetCollisionLayer(CollidesWith);
+				if (LayerBit == CollisionLayer::None || CollidesWithBit == CollisionLayer::None)
+				{
+					spdlog::warn("Unknown collision layer in interaction {} <-> {}", Layer, CollidesWith);
+				}
+				Collision.LayerMatrix.SetInteraction(LayerBit, CollidesWithBit, true);
+				j++;
+			}
 		}
 	}
-	TilemapFile.close();
 
-	Game::MapWidth = static_cast<uint16_t>(MapNumColumns * TileSize * MapScale);
-	Game::MapHeight = static_cast<uint16_t>(MapNumRows * TileSize * MapScale);
-	World.set<MapBounds>(MapBounds{ Game::MapWidth, Game::MapHeight });
+	auto& Particles = World.get_mut<ParticleState>().Particles;
+	Particles.Clear();
+	Particles.SetPoolCapacity(Level["particles"]["pool_capacity"].get_or(ParticlePool::DefaultCapacity));
+
+	ReserveProjectiles(World, Level["projectiles"]["pool_size"].get_or(ProjectilePoolState::DefaultCapacity));
 
 	sol::table Entities = Level["entities"];
 	i = 0;
@@ -115,18 +201,21 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 		}
 
 		sol::table AnEntity = Entities[i];
-		flecs::entity NewEntity = World.entity();
+		flecs::entity NewEntity = World.entity().add<LevelEntityTag>();
 
+		uint32_t CollisionLayers = CollisionLayer::None;
 		sol::optional<std::string> Tag = AnEntity["tag"];
 		if (Tag != sol::nullopt)
 		{
 			ApplyGameplayTag(World, NewEntity, *Tag);
+			CollisionLayers |= GetCollisionLayer(*Tag);
 		}
 
 		sol::optional<std::string> Group = AnEntity["group"];
 		if (Group != sol::nullopt)
 		{
 			ApplyGameplayTag(World, NewEntity, *Group);
+			CollisionLayers |= GetCollisionLayer(*Group);
 		}
 
 		sol::optional<sol::table> HasComponents = AnEntity["components"];
@@ -159,7 +248,7 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 			{
 				NewEntity.set<SpriteComponent>(SpriteComponent
 				(
-					Components["sprite"]["texture_asset_id"],
+					AssetManager->GetTextureHandle(Components["sprite"]["texture_asset_id"]),
 					Components["sprite"]["width"],
 					Components["sprite"]["height"],
 					Components["sprite"]["z_index"].get_or(1),
@@ -187,7 +276,8 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 				(
 					Components["boxcollider"]["width"],
 					Components["boxcollider"]["height"],
-					glm::vec2(Components["boxcollider"]["offset"]["x"].get_or(0.0), Components["boxcollider"]["offset"]["y"].get_or(0.0))
+					glm::vec2(Components["boxcollider"]["offset"]["x"].get_or(0.0), Components["boxcollider"]["offset"]["y"].get_or(0.0)),
+					CollisionLayers != CollisionLayer::None ? CollisionLayers : CollisionLayer::Default
 				));
 			}
 
@@ -210,6 +300,30 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 				));
 			}
 
+			sol::optional<sol::table> ParticleEmitter = Components["particle_emitter"];
+			if (ParticleEmitter != sol::nullopt)
+			{
+				NewEntity.set<ParticleEmitterComponent>(ParticleEmitterComponent
+				(
+					ReadParticleEffect(Components["particle_emitter"], *AssetManager),
+					Components["particle_emitter"]["rate"].get_or(10.0f)
+				));
+			}
+
+			sol::optional<sol::table> ParticleBursts = Components["particle_bursts"];
+			if (ParticleBursts != sol::nullopt)
+			{
+				sol::optional<sol::table> OnDestroy = Components["particle_bursts"]["on_destroy"];
+				sol::optional<sol::table> OnFire = Components["particle_bursts"]["on_fire"];
+				NewEntity.set<ParticleBurstComponent>(ParticleBurstComponent
+				(
+					OnDestroy != sol::nullopt ? ReadParticleEffect(*OnDestroy, *AssetManager) : ParticleEffect(),
+					static_cast<uint16_t>(OnDestroy != sol::nullopt ? OnDestroy->get_or("count", 0) : 0),
+					OnFire != sol::nullopt ? ReadParticleEffect(*OnFire, *AssetManager) : ParticleEffect(),
+					static_cast<uint16_t>(OnFire != sol::nullopt ? OnFire->get_or("count", 0) : 0)
+				));
+			}
+
 			sol::optional<sol::table> CameraFollow = Components["camera_follow"];
 			if (CameraFollow != sol::nullopt)
 			{
@@ -253,6 +367,23 @@ void LevelLoader::LoadLevel(sol::state& LuaState, flecs::world& World, const std
 				sol::function Funct = Components["on_update_script"][0];
 				NewEntity.set<ScriptComponent>(ScriptComponent(Funct));
 			}
+
+			sol::optional<sol::table> OnCollisionEnter = Components["on_collision_enter"];
+			sol::optional<sol::table> OnCollisionExit = Components["on_collision_exit"];
+			if (OnCollisionEnter != sol::nullopt || OnCollisionExit != sol::nullopt)
+			{
+				sol::function OnEnter = sol::lua_nil;
+				sol::function OnExit = sol::lua_nil;
+				if (OnCollisionEnter != sol::nullopt)
+				{
+					OnEnter = Components["on_collision_enter"][0];
+				}
+				if (OnCollisionExit != sol::nullopt)
+				{
+					OnExit = Components["on_collision_exit"][0];
+				}
+				NewEntity.set<CollisionScriptComponent>(CollisionScriptComponent(OnEnter, OnExit));
+			}
 		}
 
 		i++;
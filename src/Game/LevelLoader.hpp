@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../AssetManager/AssetManager.hpp"
+#include "../Tilemap/Tilemap.hpp"
 #include <flecs.h>
 
 #include <cstdint>
@@ -14,6 +15,6 @@ public:
 	LevelLoader();
 	~LevelLoader();
 
-	void LoadLevel(sol::state& LuaState, flecs::world& World, const std::unique_ptr<AssetManager>& AssetManager, SDL_Renderer* Renderer, uint8_t LevelNumber);
+	void LoadLevel(sol::state& LuaState, flecs::world& World, const std::unique_ptr<AssetManager>& AssetManager, const std::unique_ptr<Tilemap>& Map, SDL_Renderer* Renderer, uint8_t LevelNumber);
 private:
 };
\ No newline at end of file
@@ -1,10 +1,51 @@
 #include "Game/Game.hpp"
 #include <SDL3/SDL_main.h>
 
-int main(int, char*[]) {
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// --headless or RLENGINE_HEADLESS=1 selects headless mode; --frames=N or RLENGINE_FRAMES=N sets
+// how many frames to run, and --tick-rate=N or RLENGINE_TICK_RATE=N the simulation rate in Hz.
+static GameOptions ParseGameOptions(int argc, char* argv[])
+{
+	GameOptions Options;
+
+	const char* HeadlessVariable = SDL_getenv("RLENGINE_HEADLESS");
+	Options.IsHeadless = HeadlessVariable && *HeadlessVariable && std::strcmp(HeadlessVariable, "0") != 0;
+	if (const char* FramesVariable = SDL_getenv("RLENGINE_FRAMES"))
+	{
+		Options.FrameCount = static_cast<uint32_t>(std::strtoul(FramesVariable, nullptr, 10));
+	}
+	if (const char* TickRateVariable = SDL_getenv("RLENGINE_TICK_RATE"))
+	{
+		Options.TickRate = static_cast<uint16_t>(std::strtoul(TickRateVariable, nullptr, 10));
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string Argument = argv[i];
+		if (Argument == "--headless")
+		{
+			Options.IsHeadless = true;
+		}
+		else if (Argument.rfind("--frames=", 0) == 0)
+		{
+			Options.FrameCount = static_cast<uint32_t>(std::strtoul(Argument.c_str() + 9, nullptr, 10));
+		}
+		else if (Argument.rfind("--tick-rate=", 0) == 0)
+		{
+			Options.TickRate = static_cast<uint16_t>(std::strtoul(Argument.c_str() + 12, nullptr, 10));
+		}
+	}
+
+	return Options;
+}
+
+int main(int argc, char* argv[]) {
 	Game MyGame;
 
-	MyGame.Initialize();
+	MyGame.Initialize(ParseGameOptions(argc, argv));
 	MyGame.Run();
 	MyGame.Destroy();
 
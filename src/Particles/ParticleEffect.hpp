@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../AssetManager/TextureHandle.hpp"
+
+#include <SDL3/SDL.h>
+#include <glm/vec2.hpp>
+
+// What a batch of emitted particles looks like. Each particle picks its own lifetime, speed and
+// direction within the given variance; its color fades out over its lifetime.
+struct ParticleEffect
+{
+	TextureHandle Texture;
+	float Lifetime = 1.0f;
+	float LifetimeVariance = 0.0f;
+	float Speed = 50.0f;
+	float SpeedVariance = 0.0f;
+	// Degrees, clockwise from +x like TransformComponent::Rotation. Particles leave within
+	// Spread / 2 degrees either side of it.
+	float Direction = 0.0f;
+	float Spread = 360.0f;
+	float Size = 4.0f;
+	SDL_FColor Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glm::vec2 Offset = glm::vec2(0.0f);
+};
@@ -0,0 +1,126 @@
+#include "ParticlePool.hpp"
+
+ParticlePool::ParticlePool(uint32_t Capacity)
+{
+	this->Capacity = Capacity;
+	for (std::vector<float>* Array : { &PositionX, &PositionY, &VelocityX, &VelocityY, &Life, &InverseLifetime, &Size, &ColorR, &ColorG, &ColorB, &ColorA })
+	{
+		Array->resize(Capacity);
+	}
+}
+
+bool ParticlePool::Emit(const glm::vec2& Position, const glm::vec2& Velocity, float Lifetime, float ParticleSize, const SDL_FColor& Color)
+{
+	if (Count == Capacity || Lifetime <= 0.0f)
+	{
+		return false;
+	}
+
+	PositionX[Count] = Position.x;
+	PositionY[Count] = Position.y;
+	VelocityX[Count] = Velocity.x;
+	VelocityY[Count] = Velocity.y;
+	Life[Count] = Lifetime;
+	InverseLifetime[Count] = 1.0f / Lifetime;
+	Size[Count] = ParticleSize;
+	ColorR[Count] = Color.r;
+	ColorG[Count] = Color.g;
+	ColorB[Count] = Color.b;
+	ColorA[Count] = Color.a;
+	++Count;
+	return true;
+}
+
+void ParticlePool::Update(float DeltaTime)
+{
+	// Raw pointers keep the loop free of vector bounds and size reloads, so it vectorizes.
+	float* X = PositionX.data();
+	float* Y = PositionY.data();
+	const float* VX = VelocityX.data();
+	const float* VY = VelocityY.data();
+	float* Remaining = Life.data();
+	const uint32_t LiveCount = Count;
+	uint32_t DeadCount = 0;
+	for (uint32_t i = 0; i < LiveCount; ++i)
+	{
+		X[i] += VX[i] * DeltaTime;
+		Y[i] += VY[i] * DeltaTime;
+		Remaining[i] -= DeltaTime;
+		DeadCount += Remaining[i] <= 0.0f ? 1 : 0;
+	}
+
+	if (DeadCount == 0)
+	{
+		return;
+	}
+
+	uint32_t i = 0;
+	while (i < Count && DeadCount > 0)
+	{
+		if (Life[i] > 0.0f)
+		{
+			++i;
+			continue;
+		}
+
+		--DeadCount;
+		const uint32_t Last = --Count;
+		PositionX[i] = PositionX[Last];
+		PositionY[i] = PositionY[Last];
+		VelocityX[i] = VelocityX[Last];
+		VelocityY[i] = VelocityY[Last];
+		Life[i] = Life[Last];
+		InverseLifetime[i] = InverseLifetime[Last];
+		Size[i] = Size[Last];
+		ColorR[i] = ColorR[Last];
+		ColorG[i] = ColorG[Last];
+		ColorB[i] = ColorB[Last];
+		ColorA[i] = ColorA[Last];
+	}
+}
+
+void ParticlePool::Clear()
+{
+	Count = 0;
+}
+
+size_t ParticlePool::AppendVertices(const SDL_FRect& Camera, const SDL_FRect& UV, std::vector<SDL_Vertex>& Vertices) const
+{
+	const float U0 = UV.x;
+	const float V0 = UV.y;
+	const float U1 = UV.x + UV.w;
+	const float V1 = UV.y + UV.h;
+
+	Vertices.reserve(Vertices.size() + static_cast<size_t>(Count) * 4);
+	size_t QuadCount = 0;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		const float HalfSize = Size[i] * 0.5f;
+		const float Left = PositionX[i] - HalfSize - Camera.x;
+		const float Top = PositionY[i] - HalfSize - Camera.y;
+		if (Left + Size[i] < 0.0f || Top + Size[i] < 0.0f || Left > Camera.w || Top > Camera.h)
+		{
+			continue;
+		}
+
+		const float Right = Left + Size[i];
+		const float Bottom = Top + Size[i];
+		const SDL_FColor Color = { ColorR[i], ColorG[i], ColorB[i], ColorA[i] * Life[i] * InverseLifetime[i] };
+		Vertices.push_back({ { Left, Top }, Color, { U0, V0 } });
+		Vertices.push_back({ { Right, Top }, Color, { U1, V0 } });
+		Vertices.push_back({ { Right, Bottom }, Color, { U1, V1 } });
+		Vertices.push_back({ { Left, Bottom }, Color, { U0, V1 } });
+		++QuadCount;
+	}
+	return QuadCount;
+}
+
+uint32_t ParticlePool::GetCount() const
+{
+	return Count;
+}
+
+uint32_t ParticlePool::GetCapacity() const
+{
+	return Capacity;
+}
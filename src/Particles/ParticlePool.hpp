@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity structure-of-arrays storage for the particles of one texture. Live particles are
+// kept packed at the front of every array, so the update kernel is a plain loop over floats that
+// compilers vectorize, and dead particles are swapped out with the last live one.
+class ParticlePool
+{
+public:
+	static constexpr uint32_t DefaultCapacity = 16384;
+
+	explicit ParticlePool(uint32_t Capacity = DefaultCapacity);
+
+	// Returns false, dropping the particle, when the pool is full.
+	bool Emit(const glm::vec2& Position, const glm::vec2& Velocity, float Lifetime, float Size, const SDL_FColor& Color);
+	void Update(float DeltaTime);
+	void Clear();
+
+	// Appends four vertices per particle overlapping Camera, in SpriteBatch corner order, with
+	// alpha scaled by the particle's remaining life. UV is the texture region in 0..1 units.
+	// Returns the number of quads appended.
+	size_t AppendVertices(const SDL_FRect& Camera, const SDL_FRect& UV, std::vector<SDL_Vertex>& Vertices) const;
+
+	uint32_t GetCount() const;
+	uint32_t GetCapacity() const;
+
+private:
+	std::vector<float> PositionX;
+	std::vector<float> PositionY;
+	std::vector<float> VelocityX;
+	std::vector<float> VelocityY;
+	std::vector<float> Life;
+	std::vector<float> InverseLifetime;
+	std::vector<float> Size;
+	std::vector<float> ColorR;
+	std::vector<float> ColorG;
+	std::vector<float> ColorB;
+	std::vector<float> ColorA;
+
+	uint32_t Count = 0;
+	uint32_t Capacity = 0;
+};
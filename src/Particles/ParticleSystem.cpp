@@ -0,0 +1,84 @@
+#include "ParticleSystem.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+void ParticleSystem::SetPoolCapacity(uint32_t Capacity)
+{
+	PoolCapacity = Capacity;
+}
+
+void ParticleSystem::Emit(const ParticleEffect& Effect, const glm::vec2& Position, uint32_t Count)
+{
+	if (Count == 0 || !Effect.Texture.IsValid())
+	{
+		return;
+	}
+
+	ParticlePool& Pool = GetPool(Effect.Texture);
+	std::uniform_real_distribution<float> Unit(-0.5f, 0.5f);
+	const glm::vec2 Origin = Position + Effect.Offset;
+	for (uint32_t i = 0; i < Count; ++i)
+	{
+		const float Degrees = Effect.Direction + Unit(Random) * Effect.Spread;
+		const float Speed = Effect.Speed + Unit(Random) * Effect.SpeedVariance;
+		const float Lifetime = Effect.Lifetime + Unit(Random) * Effect.LifetimeVariance;
+		// Variance can take a short lifetime to zero or below; that particle would be dead on arrival.
+		if (Lifetime <= 0.0f)
+		{
+			continue;
+		}
+
+		const float Radians = glm::radians(Degrees);
+		// With the lifetime checked above, a failed emit means the pool is full.
+		if (!Pool.Emit(Origin, glm::vec2(std::cos(Radians), std::sin(Radians)) * Speed, Lifetime, Effect.Size, Effect.Color))
+		{
+			return;
+		}
+	}
+}
+
+void ParticleSystem::Update(float DeltaTime)
+{
+	for (TexturePool& Entry : Pools)
+	{
+		Entry.Pool.Update(DeltaTime);
+	}
+}
+
+void ParticleSystem::Clear()
+{
+	Pools.clear();
+}
+
+const std::vector<ParticleSystem::TexturePool>& ParticleSystem::GetPools() const
+{
+	return Pools;
+}
+
+uint32_t ParticleSystem::GetParticleCount() const
+{
+	uint32_t Count = 0;
+	for (const TexturePool& Entry : Pools)
+	{
+		Count += Entry.Pool.GetCount();
+	}
+	return Count;
+}
+
+ParticlePool& ParticleSystem::GetPool(TextureHandle Texture)
+{
+	const auto Existing = std::find_if(Pools.begin(), Pools.end(), [Texture](const TexturePool& Entry)
+	{
+		return Entry.Texture == Texture;
+	});
+	if (Existing != Pools.end())
+	{
+		return Existing->Pool;
+	}
+
+	Pools.push_back({ Texture, ParticlePool(PoolCapacity) });
+	return Pools.back().Pool;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "ParticleEffect.hpp"
+#include "ParticlePool.hpp"
+
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Owns one ParticlePool per texture, so every texture's particles go out in a single draw call.
+class ParticleSystem
+{
+public:
+	struct TexturePool
+	{
+		TextureHandle Texture;
+		ParticlePool Pool;
+	};
+
+	// Applies to pools created after the call; Clear() drops the existing ones.
+	void SetPoolCapacity(uint32_t Capacity);
+
+	// Spawns Count particles around Position + Effect.Offset. Particles that do not fit in the
+	// texture's pool are dropped.
+	void Emit(const ParticleEffect& Effect, const glm::vec2& Position, uint32_t Count);
+	void Update(float DeltaTime);
+	void Clear();
+
+	const std::vector<TexturePool>& GetPools() const;
+	uint32_t GetParticleCount() const;
+
+private:
+	ParticlePool& GetPool(TextureHandle Texture);
+
+	std::vector<TexturePool> Pools;
+	uint32_t PoolCapacity = ParticlePool::DefaultCapacity;
+	std::minstd_rand Random;
+};
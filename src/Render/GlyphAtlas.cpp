@@ -0,0 +1,112 @@
+#include "GlyphAtlas.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+static constexpr int GlyphAtlasWidth = 256;
+static constexpr int GlyphSpacing = 1;
+
+GlyphAtlas::~GlyphAtlas()
+{
+	if (Texture)
+	{
+		SDL_DestroyTexture(Texture);
+	}
+}
+
+bool GlyphAtlas::Build(SDL_Renderer* Renderer, TTF_Font* Font)
+{
+	if (!Renderer || !Font)
+	{
+		return false;
+	}
+
+	std::array<SDL_Surface*, LastCharacter - FirstCharacter + 1> GlyphSurfaces = {};
+	int CursorX = 0;
+	int CursorY = 0;
+	int RowHeight = 0;
+	for (char Character = FirstCharacter; Character <= LastCharacter; ++Character)
+	{
+		const size_t Index = static_cast<size_t>(Character - FirstCharacter);
+		SDL_Surface* Rendered = TTF_RenderGlyph_Blended(Font, static_cast<Uint32>(Character), SDL_Color{ 255, 255, 255, 255 });
+		SDL_Surface* Surface = Rendered ? SDL_ConvertSurface(Rendered, SDL_PIXELFORMAT_RGBA32) : nullptr;
+		SDL_DestroySurface(Rendered);
+		if (!Surface)
+		{
+			continue;
+		}
+
+		if (CursorX + Surface->w > GlyphAtlasWidth)
+		{
+			CursorX = 0;
+			CursorY += RowHeight + GlyphSpacing;
+			RowHeight = 0;
+		}
+
+		Glyphs[Index].SourceRectangle = { static_cast<float>(CursorX), static_cast<float>(CursorY), static_cast<float>(Surface->w), static_cast<float>(Surface->h) };
+		Glyphs[Index].Advance = static_cast<float>(Surface->w);
+		GlyphSurfaces[Index] = Surface;
+
+		CursorX += Surface->w + GlyphSpacing;
+		RowHeight = (std::max)(RowHeight, Surface->h);
+	}
+
+	SDL_Surface* AtlasSurface = SDL_CreateSurface(GlyphAtlasWidth, CursorY + RowHeight, SDL_PIXELFORMAT_RGBA32);
+	if (AtlasSurface)
+	{
+		SDL_FillSurfaceRect(AtlasSurface, nullptr, 0);
+	}
+	for (size_t Index = 0; Index < GlyphSurfaces.size(); ++Index)
+	{
+		if (!GlyphSurfaces[Index])
+		{
+			continue;
+		}
+
+		if (AtlasSurface)
+		{
+			const SDL_FRect& Source = Glyphs[Index].SourceRectangle;
+			SDL_Rect Destination = { static_cast<int>(Source.x), static_cast<int>(Source.y), static_cast<int>(Source.w), static_cast<int>(Source.h) };
+			SDL_SetSurfaceBlendMode(GlyphSurfaces[Index], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(GlyphSurfaces[Index], nullptr, AtlasSurface, &Destination);
+		}
+		SDL_DestroySurface(GlyphSurfaces[Index]);
+	}
+
+	if (!AtlasSurface)
+	{
+		spdlog::error("Could not create glyph atlas surface: {}", SDL_GetError());
+		return false;
+	}
+
+	if (Texture)
+	{
+		SDL_DestroyTexture(Texture);
+	}
+	Texture = SDL_CreateTextureFromSurface(Renderer, AtlasSurface);
+	SDL_DestroySurface(AtlasSurface);
+	SDL_SetTextureBlendMode(Texture, SDL_BLENDMODE_BLEND);
+	LineHeight = static_cast<float>(TTF_GetFontHeight(Font));
+	return Texture != nullptr;
+}
+
+void GlyphAtlas::AddText(SpriteBatch& Batch, std::string_view Text, float X, float Y, const SDL_FColor& Color, int ZIndex) const
+{
+	for (const char Character : Text)
+	{
+		const char Printable = Character >= FirstCharacter && Character <= LastCharacter ? Character : '?';
+		const Glyph& Current = Glyphs[static_cast<size_t>(Printable - FirstCharacter)];
+		if (Printable != ' ' && Current.SourceRectangle.w > 0.0f)
+		{
+			const SDL_FRect DestinationRectangle = { X, Y, Current.SourceRectangle.w, Current.SourceRectangle.h };
+			Batch.Add(Texture, ZIndex, Current.SourceRectangle, DestinationRectangle, 0.0, SDL_FLIP_NONE, Color);
+		}
+		X += Current.Advance;
+	}
+}
+
+float GlyphAtlas::GetLineHeight() const
+{
+	return LineHeight;
+}
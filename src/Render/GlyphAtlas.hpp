@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SpriteBatch.hpp"
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include <array>
+#include <string_view>
+
+// Printable ASCII glyphs of one font rasterized once, in white, into a single texture. Text is
+// then drawn as tinted quads through a SpriteBatch, with no allocations or texture uploads.
+class GlyphAtlas
+{
+public:
+	static constexpr char FirstCharacter = ' ';
+	static constexpr char LastCharacter = '~';
+
+	GlyphAtlas() = default;
+	~GlyphAtlas();
+
+	GlyphAtlas(const GlyphAtlas&) = delete;
+	GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+	bool Build(SDL_Renderer* Renderer, TTF_Font* Font);
+	void AddText(SpriteBatch& Batch, std::string_view Text, float X, float Y, const SDL_FColor& Color, int ZIndex) const;
+
+	float GetLineHeight() const;
+
+private:
+	struct Glyph
+	{
+		SDL_FRect SourceRectangle;
+		float Advance;
+	};
+
+	std::array<Glyph, LastCharacter - FirstCharacter + 1> Glyphs = {};
+	SDL_Texture* Texture = nullptr;
+	float LineHeight = 0.0f;
+};
@@ -0,0 +1,110 @@
+#include "RenderCommandList.hpp"
+
+void RenderCommandList::Reset()
+{
+	Commands.clear();
+	Vertices.clear();
+	HasDebugUi = false;
+}
+
+void RenderCommandList::SetTarget(SDL_Texture* Target, float Scale)
+{
+	Commands.push_back({ CommandType::Target, Target, {}, {}, {}, 0, 0, Scale });
+}
+
+void RenderCommandList::ClearTarget(SDL_Color Color)
+{
+	Commands.push_back({ CommandType::Clear, nullptr, {}, {}, Color, 0, 0, 1.0f });
+}
+
+void RenderCommandList::DrawQuads(SDL_Texture* Texture, const SDL_Vertex* QuadVertices, size_t QuadCount)
+{
+	if (QuadCount == 0)
+	{
+		return;
+	}
+
+	Commands.push_back({ CommandType::Quads, Texture, {}, {}, {}, static_cast<uint32_t>(Vertices.size()), static_cast<uint32_t>(QuadCount), 1.0f });
+	Vertices.insert(Vertices.end(), QuadVertices, QuadVertices + QuadCount * 4);
+
+	for (size_t Quad = QuadIndices.size() / 6; Quad < QuadCount; ++Quad)
+	{
+		const int First = static_cast<int>(Quad * 4);
+		QuadIndices.insert(QuadIndices.end(), { First, First + 1, First + 2, First, First + 2, First + 3 });
+	}
+}
+
+void RenderCommandList::DrawTexture(SDL_Texture* Texture, const SDL_FRect& DestinationRectangle)
+{
+	if (Texture)
+	{
+		Commands.push_back({ CommandType::Texture, Texture, DestinationRectangle, {}, {}, 0, 0, 1.0f });
+	}
+}
+
+void RenderCommandList::DrawTextureRegion(SDL_Texture* Texture, const SDL_FRect& SourceRectangle, const SDL_FRect& DestinationRectangle)
+{
+	if (Texture)
+	{
+		Commands.push_back({ CommandType::TextureRegion, Texture, DestinationRectangle, SourceRectangle, {}, 0, 0, 1.0f });
+	}
+}
+
+void RenderCommandList::DrawRectOutline(const SDL_FRect& Rectangle, SDL_Color Color)
+{
+	Commands.push_back({ CommandType::RectOutline, nullptr, Rectangle, {}, Color, 0, 0, 1.0f });
+}
+
+void RenderCommandList::SetDrawsDebugUi(bool DrawsDebugUi)
+{
+	HasDebugUi = DrawsDebugUi;
+}
+
+bool RenderCommandList::DrawsDebugUi() const
+{
+	return HasDebugUi;
+}
+
+void RenderCommandList::Execute(SDL_Renderer* Renderer) const
+{
+	for (const Command& Current : Commands)
+	{
+		switch (Current.Type)
+		{
+		case CommandType::Target:
+			SDL_SetRenderTarget(Renderer, Current.Texture);
+			SDL_SetRenderScale(Renderer, Current.Scale, Current.Scale);
+			break;
+		case CommandType::Clear:
+			SDL_SetRenderDrawColor(Renderer, Current.Color.r, Current.Color.g, Current.Color.b, Current.Color.a);
+			SDL_RenderClear(Renderer);
+			break;
+		case CommandType::Quads:
+			SDL_RenderGeometry
+			(
+				Renderer,
+				Current.Texture,
+				Vertices.data() + Current.FirstVertex,
+				static_cast<int>(Current.QuadCount * 4),
+				QuadIndices.data(),
+				static_cast<int>(Current.QuadCount * 6)
+			);
+			break;
+		case CommandType::Texture:
+			SDL_RenderTexture(Renderer, Current.Texture, nullptr, &Current.Rectangle);
+			break;
+		case CommandType::TextureRegion:
+			SDL_RenderTexture(Renderer, Current.Texture, &Current.SourceRectangle, &Current.Rectangle);
+			break;
+		case CommandType::RectOutline:
+			SDL_SetRenderDrawColor(Renderer, Current.Color.r, Current.Color.g, Current.Color.b, Current.Color.a);
+			SDL_RenderRect(Renderer, &Current.Rectangle);
+			break;
+		}
+	}
+}
+
+size_t RenderCommandList::GetCommandCount() const
+{
+	return Commands.size();
+}
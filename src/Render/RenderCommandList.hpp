@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A frame's worth of draw calls, recorded by the render systems and replayed later with Execute().
+// Vertex data is copied in, so a recorded list does not depend on anything the simulation may
+// change afterwards. Textures are referenced, not owned: they must outlive the list's execution.
+class RenderCommandList
+{
+public:
+	void Reset();
+
+	// Null Target draws to the window again. Scale multiplies every coordinate drawn afterwards.
+	void SetTarget(SDL_Texture* Target, float Scale);
+	void ClearTarget(SDL_Color Color);
+	// Vertices are four per quad, in the corner order SpriteBatch produces.
+	void DrawQuads(SDL_Texture* Texture, const SDL_Vertex* Vertices, size_t QuadCount);
+	void DrawTexture(SDL_Texture* Texture, const SDL_FRect& DestinationRectangle);
+	void DrawTextureRegion(SDL_Texture* Texture, const SDL_FRect& SourceRectangle, const SDL_FRect& DestinationRectangle);
+	void DrawRectOutline(const SDL_FRect& Rectangle, SDL_Color Color);
+
+	// ImGui keeps its draw data until the next ImGui::NewFrame(), and the owner of the renderer
+	// draws it after Execute(), so lists do not depend on the ImGui backend.
+	void SetDrawsDebugUi(bool DrawsDebugUi);
+	bool DrawsDebugUi() const;
+
+	void Execute(SDL_Renderer* Renderer) const;
+
+	size_t GetCommandCount() const;
+
+private:
+	enum class CommandType : uint8_t
+	{
+		Target,
+		Clear,
+		Quads,
+		Texture,
+		TextureRegion,
+		RectOutline
+	};
+
+	struct Command
+	{
+		CommandType Type;
+		SDL_Texture* Texture;
+		SDL_FRect Rectangle;
+		SDL_FRect SourceRectangle;
+		SDL_Color Color;
+		uint32_t FirstVertex;
+		uint32_t QuadCount;
+		float Scale;
+	};
+
+	std::vector<Command> Commands;
+	std::vector<SDL_Vertex> Vertices;
+	// Shared by every quad command: indices are relative to the command's first vertex.
+	std::vector<int> QuadIndices;
+	bool HasDebugUi = false;
+};
@@ -0,0 +1,94 @@
+#include "ResolutionScaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ResolutionScaler::ResolutionScaler(double BudgetMilliseconds, float MinimumScale, float MaximumScale)
+{
+	this->BudgetMilliseconds = BudgetMilliseconds;
+	this->MinimumScale = MinimumScale;
+	this->MaximumScale = MaximumScale;
+	this->Scale = MaximumScale;
+}
+
+bool ResolutionScaler::AddFrameTime(double Milliseconds)
+{
+	FrameTimeSum += Milliseconds - FrameTimes[NextFrame];
+	FrameTimes[NextFrame] = Milliseconds;
+	NextFrame = (NextFrame + 1) % WindowSize;
+	FrameCount = (std::min)(FrameCount + 1, WindowSize);
+	if (FrameCount < WindowSize)
+	{
+		return false;
+	}
+
+	const double Average = FrameTimeSum / static_cast<double>(WindowSize);
+	if (Average > BudgetMilliseconds * 1.1)
+	{
+		if (WasProbing)
+		{
+			ProbeInterval = (std::min)(ProbeInterval * 2, MaxProbeFrames);
+		}
+		WasProbing = false;
+		FramesInBudget = 0;
+		if (Scale > MinimumScale)
+		{
+			SetScale(Scale - ScaleStep);
+			return true;
+		}
+		return false;
+	}
+
+	// A full window in budget after a probe means the new scale holds.
+	if (WasProbing && FramesInBudget >= WindowSize)
+	{
+		WasProbing = false;
+		ProbeInterval = ProbeFrames;
+	}
+
+	++FramesInBudget;
+	if (Scale >= MaximumScale)
+	{
+		return false;
+	}
+
+	if (Average < BudgetMilliseconds * 0.75)
+	{
+		FramesInBudget = 0;
+		SetScale(Scale + ScaleStep);
+		return true;
+	}
+
+	if (FramesInBudget >= ProbeInterval)
+	{
+		FramesInBudget = 0;
+		WasProbing = true;
+		SetScale(Scale + ScaleStep);
+		return true;
+	}
+	return false;
+}
+
+void ResolutionScaler::SetBudget(double BudgetMilliseconds)
+{
+	this->BudgetMilliseconds = BudgetMilliseconds;
+	FramesInBudget = 0;
+	ProbeInterval = ProbeFrames;
+	WasProbing = false;
+	SetScale(Scale);
+}
+
+float ResolutionScaler::GetScale() const
+{
+	return Scale;
+}
+
+// Averages taken at the old scale say nothing about the new one, so the window starts over.
+void ResolutionScaler::SetScale(float NewScale)
+{
+	Scale = std::clamp(std::round(NewScale / ScaleStep) * ScaleStep, MinimumScale, MaximumScale);
+	FrameTimes.fill(0.0);
+	FrameCount = 0;
+	NextFrame = 0;
+	FrameTimeSum = 0.0;
+}
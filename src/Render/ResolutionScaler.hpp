@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Picks the scale the world is rendered at from a rolling average of frame times. The scale drops
+// a step as soon as the average goes over budget, and rises again when there is clear headroom.
+// With VSync, frames that make it are never much faster than the budget, so an in-budget average
+// held for long enough also earns a step up; stepping up into a miss doubles that wait.
+class ResolutionScaler
+{
+public:
+	ResolutionScaler(double BudgetMilliseconds, float MinimumScale = 0.5f, float MaximumScale = 1.0f);
+
+	// Returns true when the scale changed.
+	bool AddFrameTime(double Milliseconds);
+	void SetBudget(double BudgetMilliseconds);
+	float GetScale() const;
+
+private:
+	void SetScale(float NewScale);
+
+	static constexpr size_t WindowSize = 30;
+	static constexpr float ScaleStep = 0.1f;
+	static constexpr uint32_t ProbeFrames = 120;
+	static constexpr uint32_t MaxProbeFrames = ProbeFrames * 16;
+
+	std::array<double, WindowSize> FrameTimes = {};
+	size_t FrameCount = 0;
+	size_t NextFrame = 0;
+	double FrameTimeSum = 0.0;
+
+	double BudgetMilliseconds;
+	float MinimumScale;
+	float MaximumScale;
+	float Scale;
+
+	uint32_t FramesInBudget = 0;
+	uint32_t ProbeInterval = ProbeFrames;
+	bool WasProbing = false;
+};
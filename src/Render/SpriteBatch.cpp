@@ -0,0 +1,132 @@
+#include "SpriteBatch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void SpriteBatch::Begin()
+{
+	Quads.clear();
+	Vertices.clear();
+	IsOrdered = true;
+	LastTexture = nullptr;
+	DrawCallCount = 0;
+}
+
+void SpriteBatch::Add(SDL_Texture* Texture, int ZIndex, const SDL_FRect& SourceRectangle, const SDL_FRect& DestinationRectangle, double Rotation, SDL_FlipMode Flip, const SDL_FColor& Color)
+{
+	if (!Texture)
+	{
+		return;
+	}
+
+	if (Texture != LastTexture)
+	{
+		SDL_GetTextureSize(Texture, &LastTextureWidth, &LastTextureHeight);
+		LastTexture = Texture;
+	}
+	if (LastTextureWidth <= 0.0f || LastTextureHeight <= 0.0f)
+	{
+		return;
+	}
+
+	float U0 = SourceRectangle.x / LastTextureWidth;
+	float V0 = SourceRectangle.y / LastTextureHeight;
+	float U1 = (SourceRectangle.x + SourceRectangle.w) / LastTextureWidth;
+	float V1 = (SourceRectangle.y + SourceRectangle.h) / LastTextureHeight;
+	if (Flip & SDL_FLIP_HORIZONTAL)
+	{
+		std::swap(U0, U1);
+	}
+	if (Flip & SDL_FLIP_VERTICAL)
+	{
+		std::swap(V0, V1);
+	}
+
+	// Corners relative to the rectangle center, rotated clockwise in screen space like SDL does.
+	const float HalfWidth = DestinationRectangle.w * 0.5f;
+	const float HalfHeight = DestinationRectangle.h * 0.5f;
+	const float CenterX = DestinationRectangle.x + HalfWidth;
+	const float CenterY = DestinationRectangle.y + HalfHeight;
+	const float Radians = static_cast<float>(Rotation * (3.14159265358979323846 / 180.0));
+	const float Cos = Rotation == 0.0 ? 1.0f : std::cos(Radians);
+	const float Sin = Rotation == 0.0 ? 0.0f : std::sin(Radians);
+
+	const float CornerX[4] = { -HalfWidth, HalfWidth, HalfWidth, -HalfWidth };
+	const float CornerY[4] = { -HalfHeight, -HalfHeight, HalfHeight, HalfHeight };
+	const float CornerU[4] = { U0, U1, U1, U0 };
+	const float CornerV[4] = { V0, V0, V1, V1 };
+
+	IsOrdered = IsOrdered && (Quads.empty() || Quads.back().ZIndex <= ZIndex);
+	Quads.push_back({ ZIndex, Texture, static_cast<uint32_t>(Vertices.size()) });
+	for (int Corner = 0; Corner < 4; ++Corner)
+	{
+		const SDL_FPoint Position =
+		{
+			CenterX + CornerX[Corner] * Cos - CornerY[Corner] * Sin,
+			CenterY + CornerX[Corner] * Sin + CornerY[Corner] * Cos
+		};
+		Vertices.push_back({ Position, Color, { CornerU[Corner], CornerV[Corner] } });
+	}
+}
+
+void SpriteBatch::AddRect(int ZIndex, const SDL_FRect& Rectangle, const SDL_FColor& Color)
+{
+	IsOrdered = IsOrdered && (Quads.empty() || Quads.back().ZIndex <= ZIndex);
+	Quads.push_back({ ZIndex, nullptr, static_cast<uint32_t>(Vertices.size()) });
+	Vertices.push_back({ { Rectangle.x, Rectangle.y }, Color, { 0.0f, 0.0f } });
+	Vertices.push_back({ { Rectangle.x + Rectangle.w, Rectangle.y }, Color, { 0.0f, 0.0f } });
+	Vertices.push_back({ { Rectangle.x + Rectangle.w, Rectangle.y + Rectangle.h }, Color, { 0.0f, 0.0f } });
+	Vertices.push_back({ { Rectangle.x, Rectangle.y + Rectangle.h }, Color, { 0.0f, 0.0f } });
+}
+
+void SpriteBatch::Flush(RenderCommandList& Commands)
+{
+	if (Quads.empty())
+	{
+		return;
+	}
+
+	// Submissions already in z order are drawn as they came, merging runs of the same texture.
+	// Otherwise quads are sorted, stable so sprites sharing a z-index and texture keep their order.
+	const SDL_Vertex* GroupVertices = Vertices.data();
+	if (!IsOrdered)
+	{
+		std::stable_sort(Quads.begin(), Quads.end(), [](const Quad& A, const Quad& B)
+		{
+			return A.ZIndex != B.ZIndex ? A.ZIndex < B.ZIndex : A.Texture < B.Texture;
+		});
+
+		SortedVertices.resize(Vertices.size());
+		for (size_t i = 0; i < Quads.size(); ++i)
+		{
+			std::copy_n(Vertices.begin() + Quads[i].FirstVertex, 4, SortedVertices.begin() + i * 4);
+		}
+		GroupVertices = SortedVertices.data();
+	}
+
+	size_t GroupBegin = 0;
+	while (GroupBegin < Quads.size())
+	{
+		size_t GroupEnd = GroupBegin + 1;
+		while (GroupEnd < Quads.size() && Quads[GroupEnd].ZIndex == Quads[GroupBegin].ZIndex && Quads[GroupEnd].Texture == Quads[GroupBegin].Texture)
+		{
+			++GroupEnd;
+		}
+
+		Commands.DrawQuads(Quads[GroupBegin].Texture, GroupVertices + GroupBegin * 4, GroupEnd - GroupBegin);
+		++DrawCallCount;
+
+		GroupBegin = GroupEnd;
+	}
+}
+
+size_t SpriteBatch::GetSpriteCount() const
+{
+	return Quads.size();
+}
+
+size_t SpriteBatch::GetDrawCallCount() const
+{
+	return DrawCallCount;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "RenderCommandList.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <vector>
+
+// Collects textured quads for a frame and records them into a RenderCommandList as one quad
+// command per (z-index, texture) group. Quads added in ascending z order skip the sort and keep
+// their order. Rotation, flipping and source rectangles are resolved on the CPU, matching what
+// SDL_RenderTextureRotated does with a null rotation center.
+class SpriteBatch
+{
+public:
+	void Begin();
+	void Add(SDL_Texture* Texture, int ZIndex, const SDL_FRect& SourceRectangle, const SDL_FRect& DestinationRectangle, double Rotation, SDL_FlipMode Flip, const SDL_FColor& Color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	// Untextured, solid-colour rectangle. All rectangles sharing a z-index go out in one draw call.
+	void AddRect(int ZIndex, const SDL_FRect& Rectangle, const SDL_FColor& Color);
+	void Flush(RenderCommandList& Commands);
+
+	size_t GetSpriteCount() const;
+	size_t GetDrawCallCount() const;
+
+private:
+	struct Quad
+	{
+		int ZIndex;
+		SDL_Texture* Texture;
+		uint32_t FirstVertex;
+	};
+
+	std::vector<Quad> Quads;
+	std::vector<SDL_Vertex> Vertices;
+	std::vector<SDL_Vertex> SortedVertices;
+
+	// Texture size lookups are cached for runs of sprites sharing a texture.
+	SDL_Texture* LastTexture = nullptr;
+	float LastTextureWidth = 0.0f;
+	float LastTextureHeight = 0.0f;
+
+	size_t DrawCallCount = 0;
+	bool IsOrdered = true;
+};
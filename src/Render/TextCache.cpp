@@ -0,0 +1,115 @@
+#include "TextCache.hpp"
+
+#include <spdlog/spdlog.h>
+
+TextCache::TextCache(size_t BudgetBytes)
+	: BudgetBytes(BudgetBytes)
+{
+}
+
+TextCache::~TextCache()
+{
+	Clear();
+}
+
+TextCache::Entry* TextCache::Acquire(SDL_Renderer* Renderer, TTF_Font* Font, const std::string& FontID, const std::string& Text, SDL_Color Color)
+{
+	std::string Key = FontID;
+	Key.push_back('\0');
+	Key.append(Text);
+	Key.push_back('\0');
+	Key.append({ static_cast<char>(Color.r), static_cast<char>(Color.g), static_cast<char>(Color.b), static_cast<char>(Color.a) });
+
+	const auto Found = Lookup.find(Key);
+	if (Found != Lookup.end())
+	{
+		Entries.splice(Entries.begin(), Entries, Found->second);
+		Found->second->References++;
+		return &*Found->second;
+	}
+
+	Entry NewEntry;
+	NewEntry.Key = Key;
+	NewEntry.References = 1;
+	if (Font && !Text.empty())
+	{
+		SDL_Surface* TextSurface = TTF_RenderText_Blended(Font, Text.c_str(), 0, Color);
+		if (TextSurface)
+		{
+			NewEntry.Texture = SDL_CreateTextureFromSurface(Renderer, TextSurface);
+			NewEntry.Bytes = static_cast<size_t>(TextSurface->w) * TextSurface->h * 4;
+			SDL_DestroySurface(TextSurface);
+			SDL_GetTextureSize(NewEntry.Texture, &NewEntry.Width, &NewEntry.Height);
+		}
+		else
+		{
+			spdlog::error("Could not render text \"{}\" with font {}: {}", Text, FontID, SDL_GetError());
+		}
+	}
+
+	Entries.push_front(std::move(NewEntry));
+	Lookup.emplace(Key, Entries.begin());
+	UsedBytes += Entries.front().Bytes;
+	EvictToBudget();
+	return &Entries.front();
+}
+
+void TextCache::Release(Entry* CachedEntry)
+{
+	if (CachedEntry && CachedEntry->References > 0)
+	{
+		CachedEntry->References--;
+		EvictToBudget();
+	}
+}
+
+void TextCache::SetBudget(size_t BudgetBytes)
+{
+	this->BudgetBytes = BudgetBytes;
+	EvictToBudget();
+}
+
+size_t TextCache::GetBudget() const
+{
+	return BudgetBytes;
+}
+
+size_t TextCache::GetUsedBytes() const
+{
+	return UsedBytes;
+}
+
+size_t TextCache::GetEntryCount() const
+{
+	return Entries.size();
+}
+
+void TextCache::Clear()
+{
+	for (Entry& CachedEntry : Entries)
+	{
+		SDL_DestroyTexture(CachedEntry.Texture);
+	}
+	Entries.clear();
+	Lookup.clear();
+	UsedBytes = 0;
+}
+
+// Pinned entries are never evicted, so the budget can be exceeded while they are all in use.
+void TextCache::EvictToBudget()
+{
+	auto Current = Entries.end();
+	while (UsedBytes > BudgetBytes && Current != Entries.begin())
+	{
+		--Current;
+		if (Current->References > 0)
+		{
+			continue;
+		}
+
+		UsedBytes -= Current->Bytes;
+		SDL_DestroyTexture(Current->Texture);
+		Lookup.erase(Current->Key);
+		Current = Entries.erase(Current);
+	}
+}
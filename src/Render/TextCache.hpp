@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+// Rasterized text textures keyed by (font id, text, color). Entries in use are pinned with
+// Acquire/Release; released entries stay cached and are evicted least recently used first once
+// the cache goes over its memory budget.
+class TextCache
+{
+public:
+	static constexpr size_t DefaultBudgetBytes = 8 * 1024 * 1024;
+
+	struct Entry
+	{
+		std::string Key;
+		SDL_Texture* Texture = nullptr;
+		float Width = 0.0f;
+		float Height = 0.0f;
+		size_t Bytes = 0;
+		uint32_t References = 0;
+	};
+
+	explicit TextCache(size_t BudgetBytes = DefaultBudgetBytes);
+	~TextCache();
+
+	TextCache(const TextCache&) = delete;
+	TextCache& operator=(const TextCache&) = delete;
+	TextCache(TextCache&&) = default;
+	TextCache& operator=(TextCache&&) = default;
+
+	// Returns the cached texture for this text, rasterizing it on a miss. Never returns null, but
+	// Texture is null when the text could not be rendered (e.g. empty string or missing font).
+	Entry* Acquire(SDL_Renderer* Renderer, TTF_Font* Font, const std::string& FontID, const std::string& Text, SDL_Color Color);
+	void Release(Entry* CachedEntry);
+
+	void SetBudget(size_t BudgetBytes);
+	size_t GetBudget() const;
+	size_t GetUsedBytes() const;
+	size_t GetEntryCount() const;
+	void Clear();
+
+private:
+	void EvictToBudget();
+
+	size_t BudgetBytes;
+	size_t UsedBytes = 0;
+	// Most recently used first.
+	std::list<Entry> Entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> Lookup;
+};
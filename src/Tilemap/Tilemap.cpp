@@ -0,0 +1,240 @@
+#include "Tilemap.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+Tilemap::Tilemap()
+{
+}
+
+Tilemap::~Tilemap()
+{
+	DestroyChunks();
+}
+
+bool Tilemap::Load(const std::string& MapFilePath, uint16_t NumRows, uint16_t NumColumns, uint16_t TileSize, float Scale)
+{
+	Clear();
+
+	std::fstream TilemapFile;
+	TilemapFile.open(MapFilePath, std::ios::in);
+	if (!TilemapFile.is_open())
+	{
+		spdlog::error("Could not open tilemap file {}", MapFilePath);
+		return false;
+	}
+
+	this->NumRows = NumRows;
+	this->NumColumns = NumColumns;
+	this->TileSize = TileSize;
+	this->Scale = Scale;
+
+	Tiles.reserve(static_cast<size_t>(NumRows) * NumColumns);
+	for (uint16_t y = 0; y < NumRows; y++)
+	{
+		for (uint16_t x = 0; x < NumColumns; x++)
+		{
+			// Each tile is two digits, the tileset row then the column, followed by a separator.
+			char ch;
+			TilemapFile.get(ch);
+			const uint16_t SourceY = static_cast<uint16_t>((ch - '0') * TileSize);
+			TilemapFile.get(ch);
+			const uint16_t SourceX = static_cast<uint16_t>((ch - '0') * TileSize);
+			TilemapFile.ignore();
+
+			Tiles.push_back({ SourceX, SourceY });
+		}
+	}
+	TilemapFile.close();
+
+	NumChunkRows = static_cast<uint16_t>((NumRows + ChunkTiles - 1) / ChunkTiles);
+	NumChunkColumns = static_cast<uint16_t>((NumColumns + ChunkTiles - 1) / ChunkTiles);
+	return true;
+}
+
+void Tilemap::Bake(SDL_Renderer* Renderer, AssetManager& Assets, TextureHandle Tileset)
+{
+	DestroyChunks();
+	this->Assets = &Assets;
+	this->Tileset = Tileset;
+	const TextureRegion& Region = Assets.GetTextureRegion(Tileset);
+	if (!Renderer || !Region.Texture || Tiles.empty())
+	{
+		return;
+	}
+
+	// Chunks are scaled when drawn, so sample them the same way the tiles would have been sampled.
+	SDL_ScaleMode ScaleMode = SDL_SCALEMODE_LINEAR;
+	SDL_GetTextureScaleMode(Region.Texture, &ScaleMode);
+
+	for (uint16_t ChunkY = 0; ChunkY < NumChunkRows; ChunkY++)
+	{
+		for (uint16_t ChunkX = 0; ChunkX < NumChunkColumns; ChunkX++)
+		{
+			const int ChunkColumns = (std::min)(static_cast<int>(ChunkTiles), NumColumns - ChunkX * ChunkTiles);
+			const int ChunkRows = (std::min)(static_cast<int>(ChunkTiles), NumRows - ChunkY * ChunkTiles);
+			SDL_Texture* Chunk = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, ChunkColumns * TileSize, ChunkRows * TileSize);
+			if (!Chunk)
+			{
+				spdlog::error("Could not create tilemap chunk texture: {}", SDL_GetError());
+			}
+			else
+			{
+				SDL_SetTextureBlendMode(Chunk, SDL_BLENDMODE_BLEND);
+				SDL_SetTextureScaleMode(Chunk, ScaleMode);
+			}
+			Chunks.push_back(Chunk);
+		}
+	}
+
+	Rebake(Renderer);
+	spdlog::info("Tilemap baked into {} chunks of {}x{} tiles", Chunks.size(), ChunkTiles, ChunkTiles);
+}
+
+void Tilemap::Recreate(SDL_Renderer* Renderer)
+{
+	if (Assets)
+	{
+		Bake(Renderer, *Assets, Tileset);
+	}
+}
+
+void Tilemap::Rebake(SDL_Renderer* Renderer)
+{
+	if (!Renderer || !Assets)
+	{
+		return;
+	}
+
+	const TextureRegion Region = Assets->GetTextureRegion(Tileset);
+	if (!Region.Texture)
+	{
+		return;
+	}
+
+	SDL_Texture* PreviousTarget = SDL_GetRenderTarget(Renderer);
+	for (uint16_t ChunkY = 0; ChunkY < NumChunkRows; ChunkY++)
+	{
+		for (uint16_t ChunkX = 0; ChunkX < NumChunkColumns; ChunkX++)
+		{
+			SDL_Texture* Chunk = Chunks[static_cast<size_t>(ChunkY) * NumChunkColumns + ChunkX];
+			if (!Chunk)
+			{
+				continue;
+			}
+
+			SDL_SetRenderTarget(Renderer, Chunk);
+			SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 0);
+			SDL_RenderClear(Renderer);
+
+			const uint16_t FirstRow = static_cast<uint16_t>(ChunkY * ChunkTiles);
+			const uint16_t FirstColumn = static_cast<uint16_t>(ChunkX * ChunkTiles);
+			const uint16_t LastRow = (std::min)(static_cast<uint16_t>(FirstRow + ChunkTiles), NumRows);
+			const uint16_t LastColumn = (std::min)(static_cast<uint16_t>(FirstColumn + ChunkTiles), NumColumns);
+			for (uint16_t y = FirstRow; y < LastRow; y++)
+			{
+				for (uint16_t x = FirstColumn; x < LastColumn; x++)
+				{
+					const Tile& Current = Tiles[static_cast<size_t>(y) * NumColumns + x];
+					const SDL_FRect SourceRectangle =
+					{
+						Region.Rect.x + Current.SourceX,
+						Region.Rect.y + Current.SourceY,
+						static_cast<float>(TileSize),
+						static_cast<float>(TileSize)
+					};
+					const SDL_FRect DestinationRectangle =
+					{
+						static_cast<float>((x - FirstColumn) * TileSize),
+						static_cast<float>((y - FirstRow) * TileSize),
+						static_cast<float>(TileSize),
+						static_cast<float>(TileSize)
+					};
+					SDL_RenderTexture(Renderer, Region.Texture, &SourceRectangle, &DestinationRectangle);
+				}
+			}
+		}
+	}
+	SDL_SetRenderTarget(Renderer, PreviousTarget);
+}
+
+void Tilemap::Render(RenderCommandList& Commands, const SDL_FRect& Camera) const
+{
+	if (Chunks.empty())
+	{
+		return;
+	}
+
+	// Only the chunk range overlapping the camera is visited, so the cost does not grow with the map size.
+	const float ChunkWorldSize = static_cast<float>(ChunkTiles * TileSize) * Scale;
+	const int FirstChunkX = (std::max)(0, static_cast<int>(std::floor(Camera.x / ChunkWorldSize)));
+	const int FirstChunkY = (std::max)(0, static_cast<int>(std::floor(Camera.y / ChunkWorldSize)));
+	const int LastChunkX = (std::min)(NumChunkColumns - 1, static_cast<int>(std::floor((Camera.x + Camera.w) / ChunkWorldSize)));
+	const int LastChunkY = (std::min)(NumChunkRows - 1, static_cast<int>(std::floor((Camera.y + Camera.h) / ChunkWorldSize)));
+
+	for (int ChunkY = FirstChunkY; ChunkY <= LastChunkY; ChunkY++)
+	{
+		for (int ChunkX = FirstChunkX; ChunkX <= LastChunkX; ChunkX++)
+		{
+			SDL_Texture* Chunk = Chunks[static_cast<size_t>(ChunkY) * NumChunkColumns + ChunkX];
+			if (!Chunk)
+			{
+				continue;
+			}
+
+			float ChunkWidth = 0.0f;
+			float ChunkHeight = 0.0f;
+			SDL_GetTextureSize(Chunk, &ChunkWidth, &ChunkHeight);
+			const SDL_FRect DestinationRectangle =
+			{
+				std::round(ChunkX * ChunkWorldSize - Camera.x),
+				std::round(ChunkY * ChunkWorldSize - Camera.y),
+				std::ceil(ChunkWidth * Scale),
+				std::ceil(ChunkHeight * Scale)
+			};
+			Commands.DrawTexture(Chunk, DestinationRectangle);
+		}
+	}
+}
+
+void Tilemap::Clear()
+{
+	DestroyChunks();
+	Tiles.clear();
+	Assets = nullptr;
+	Tileset = TextureHandle();
+	NumRows = 0;
+	NumColumns = 0;
+	NumChunkRows = 0;
+	NumChunkColumns = 0;
+}
+
+uint16_t Tilemap::GetWidth() const
+{
+	return static_cast<uint16_t>(NumColumns * TileSize * Scale);
+}
+
+uint16_t Tilemap::GetHeight() const
+{
+	return static_cast<uint16_t>(NumRows * TileSize * Scale);
+}
+
+size_t Tilemap::GetChunkCount() const
+{
+	return Chunks.size();
+}
+
+void Tilemap::DestroyChunks()
+{
+	for (SDL_Texture* Chunk : Chunks)
+	{
+		if (Chunk)
+		{
+			SDL_DestroyTexture(Chunk);
+		}
+	}
+	Chunks.clear();
+}
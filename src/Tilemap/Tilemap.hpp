@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../AssetManager/AssetManager.hpp"
+#include "../Render/RenderCommandList.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Static tile layer baked into fixed-size chunk textures. Instead of one entity and one draw call
+// per tile, the map is drawn with one call per visible chunk.
+class Tilemap
+{
+public:
+	static constexpr uint16_t ChunkTiles = 16;
+
+	Tilemap();
+	~Tilemap();
+
+	Tilemap(const Tilemap&) = delete;
+	Tilemap& operator=(const Tilemap&) = delete;
+
+	bool Load(const std::string& MapFilePath, uint16_t NumRows, uint16_t NumColumns, uint16_t TileSize, float Scale);
+	// The tileset is only drawn from while baking, so it is kept as a handle: a lazy texture can be
+	// evicted once the chunks are baked, and resolving the handle again makes it resident.
+	void Bake(SDL_Renderer* Renderer, AssetManager& Assets, TextureHandle Tileset);
+	// Render target contents are lost on some backends (SDL_EVENT_RENDER_TARGETS_RESET); this redraws the chunks.
+	void Rebake(SDL_Renderer* Renderer);
+	// After SDL_EVENT_RENDER_DEVICE_RESET the chunk textures themselves are gone, so they are created again.
+	void Recreate(SDL_Renderer* Renderer);
+	void Render(RenderCommandList& Commands, const SDL_FRect& Camera) const;
+	void Clear();
+
+	uint16_t GetWidth() const;
+	uint16_t GetHeight() const;
+	size_t GetChunkCount() const;
+
+private:
+	struct Tile
+	{
+		uint16_t SourceX;
+		uint16_t SourceY;
+	};
+
+	void DestroyChunks();
+
+	uint16_t NumRows = 0;
+	uint16_t NumColumns = 0;
+	uint16_t TileSize = 0;
+	float Scale = 1.0f;
+	uint16_t NumChunkRows = 0;
+	uint16_t NumChunkColumns = 0;
+
+	std::vector<Tile> Tiles;
+	// Row-major, NumChunkColumns per row. Chunks on the right and bottom edges can be smaller.
+	std::vector<SDL_Texture*> Chunks;
+	AssetManager* Assets = nullptr;
+	TextureHandle Tileset;
+};
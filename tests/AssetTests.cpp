@@ -0,0 +1,83 @@
+#include "../src/AssetManager/AssetManager.hpp"
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+static bool Expect(bool Condition, const char* Message)
+{
+	if (!Condition)
+	{
+		std::printf("%s\n", Message);
+	}
+	return Condition;
+}
+
+// Level B keeps only the font of level A. Both of A's textures are released, which takes the
+// reference count of the atlas page they were packed into to zero and frees it before B is packed.
+static bool CheckLevelTransition(SDL_Renderer* Renderer)
+{
+	AssetManager Assets;
+	AssetLoader Loader(2);
+	const std::vector<FontFile> Fonts = { FontFile{ "arial-font", "./assets/fonts/arial.ttf", 16 } };
+	const std::vector<std::pair<std::string, std::string>> LevelATextures =
+	{
+		{ "tank-texture", "./assets/images/tank-tiger-up.png" },
+		{ "truck-texture", "./assets/images/truck-ford-up.png" }
+	};
+	const std::vector<std::pair<std::string, std::string>> LevelBTextures =
+	{
+		{ "tree-texture", "./assets/images/tree.png" }
+	};
+
+	bool IsPassing = true;
+	const LevelAssetCounts LevelA = Assets.LoadLevelAssets(Renderer, LevelATextures, Fonts, Loader);
+	IsPassing &= Expect(LevelA.Kept == 0 && LevelA.Released == 0 && LevelA.Loaded == 3, "Level A did not load its two textures and font");
+	IsPassing &= Expect(Assets.GetAtlasPageCount() == 1, "Level A's textures were not packed into one atlas page");
+
+	const TextureHandle Tank = Assets.GetTextureHandle("tank-texture");
+	const size_t PageBytes = Assets.GetAtlasPageBytes();
+	IsPassing &= Expect(Assets.GetTextureRegion(Tank).Texture != nullptr, "Level A's texture is not resident");
+
+	const LevelAssetCounts LevelB = Assets.LoadLevelAssets(Renderer, LevelBTextures, Fonts, Loader);
+	IsPassing &= Expect(LevelB.Kept == 1 && LevelB.Released == 2 && LevelB.Loaded == 1, "Level B did not keep the font, release two textures and load one");
+
+	const auto& Records = Assets.GetAssetRecords();
+	IsPassing &= Expect(!Records.contains("tank-texture") && !Records.contains("truck-texture"), "Level A's textures still have records");
+	IsPassing &= Expect(Records.contains("arial-font") && Records.at("arial-font").RefCount == 1, "The shared font does not hold exactly one reference");
+	IsPassing &= Expect(Assets.GetTextureRegion(Tank).Texture == nullptr, "Level A's texture region still points at a page");
+	IsPassing &= Expect(Assets.GetAtlasPageCount() == 1 && Assets.GetAtlasPageBytes() == PageBytes, "Level A's atlas page was not freed");
+	return IsPassing;
+}
+
+int main()
+{
+	// The test runs from the repository root, like the game, so the asset paths resolve.
+	if (!SDL_Init(SDL_INIT_EVENTS) || !TTF_Init())
+	{
+		std::printf("Could not initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	SDL_Surface* Target = SDL_CreateSurface(64, 64, SDL_PIXELFORMAT_RGBA8888);
+	SDL_Renderer* Renderer = Target ? SDL_CreateSoftwareRenderer(Target) : nullptr;
+	if (!Renderer)
+	{
+		std::printf("Could not create a software renderer: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	const bool IsPassing = CheckLevelTransition(Renderer);
+
+	SDL_DestroyRenderer(Renderer);
+	SDL_DestroySurface(Target);
+	TTF_Quit();
+	SDL_Quit();
+
+	std::printf(IsPassing ? "Asset tests passed\n" : "Asset tests failed\n");
+	return IsPassing ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#include "../src/Collision/ContactCache.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Pooled projectiles come back with the same entity id. Releasing one erases its cached contacts,
+// so hitting the same partner right after being re-spawned begins a new contact instead of persisting.
+static bool CheckRecycledContactBegins()
+{
+	const uint64_t Projectile = 7;
+	const uint64_t Target = 9;
+	std::vector<CollisionCandidate> Contacts = { { 3, 4, 0, 0 }, { Projectile, Target, 0, 0 } };
+	std::vector<CollisionCandidate> Erased;
+	EraseContactsOf(Contacts, { Projectile }, Erased);
+
+	ContactEvent Event = ContactEvent::End;
+	MergeContacts({ { Projectile, Target, 0, 0 } }, Contacts, [&](const CollisionCandidate& Contact, ContactEvent NewEvent)
+	{
+		if (Contact.A == Projectile && Contact.B == Target)
+		{
+			Event = NewEvent;
+		}
+	});
+	return Erased.size() == 1 && Contacts.size() == 1 && Event == ContactEvent::Begin;
+}
+
+int main()
+{
+	if (!CheckRecycledContactBegins())
+	{
+		std::printf("A recycled entity id did not begin a new contact\n");
+		return 1;
+	}
+
+	std::printf("Collision tests passed\n");
+	return 0;
+}
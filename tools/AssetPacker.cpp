@@ -0,0 +1,202 @@
+// Bundles the textures, fonts, sounds and script of a level into one archive that AssetManager maps at
+// startup. Textures are decoded here, so the game uploads their pixels without touching a PNG.
+//
+// Usage, from the repository root: AssetPacker ./assets/scripts/Level2.lua ./assets/packs/Level2.rlpak
+
+#include "../src/AssetManager/AssetArchive.hpp"
+#include "../src/AssetManager/TextureAtlas.hpp"
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <sol/sol.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+struct PackedFile
+{
+	ArchiveEntryType Type = ArchiveEntryType::Script;
+	std::string Path;
+	std::vector<uint8_t> Data;
+	uint64_t SourceHash = 0;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+};
+
+static bool ReadWholeFile(const std::string& FilePath, std::vector<uint8_t>& OutData)
+{
+	std::ifstream File(FilePath, std::ios::binary);
+	if (!File.is_open())
+	{
+		return false;
+	}
+	OutData.assign(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static bool PackTexture(const std::string& FilePath, PackedFile& OutFile)
+{
+	SDL_Surface* Loaded = IMG_Load(FilePath.c_str());
+	SDL_Surface* Image = Loaded ? SDL_ConvertSurface(Loaded, SDL_PIXELFORMAT_RGBA32) : nullptr;
+	SDL_DestroySurface(Loaded);
+	if (!Image)
+	{
+		std::fprintf(stderr, "Could not decode %s: %s\n", FilePath.c_str(), SDL_GetError());
+		return false;
+	}
+
+	OutFile.Width = static_cast<uint32_t>(Image->w);
+	OutFile.Height = static_cast<uint32_t>(Image->h);
+	const size_t RowSize = static_cast<size_t>(Image->w) * 4;
+	OutFile.Data.resize(RowSize * Image->h);
+	for (int Row = 0; Row < Image->h; ++Row)
+	{
+		std::memcpy(OutFile.Data.data() + RowSize * Row, static_cast<const uint8_t*>(Image->pixels) + static_cast<size_t>(Image->pitch) * Row, RowSize);
+	}
+	SDL_DestroySurface(Image);
+	return true;
+}
+
+static uint64_t AlignOffset(uint64_t Offset)
+{
+	return (Offset + AssetArchiveAlignment - 1) / AssetArchiveAlignment * AssetArchiveAlignment;
+}
+
+// Written to a temporary file and renamed, so a running game never maps a half-written archive.
+static bool WriteArchive(const std::string& OutputPath, const std::vector<PackedFile>& Files)
+{
+	std::vector<AssetArchiveEntry> Table(Files.size());
+	uint64_t Offset = sizeof(AssetArchiveHeader) + sizeof(AssetArchiveEntry) * Files.size();
+	for (size_t i = 0; i < Files.size(); ++i)
+	{
+		Table[i].Type = Files[i].Type;
+		Table[i].PathLength = static_cast<uint32_t>(Files[i].Path.size());
+		Table[i].PathOffset = Offset;
+		Offset += Files[i].Path.size();
+	}
+	for (size_t i = 0; i < Files.size(); ++i)
+	{
+		Offset = AlignOffset(Offset);
+		Table[i].DataOffset = Offset;
+		Table[i].DataSize = Files[i].Data.size();
+		Table[i].SourceHash = Files[i].SourceHash;
+		Table[i].Width = Files[i].Width;
+		Table[i].Height = Files[i].Height;
+		Offset += Files[i].Data.size();
+	}
+
+	std::error_code Error;
+	std::filesystem::create_directories(std::filesystem::path(OutputPath).parent_path(), Error);
+	const std::string TemporaryPath = OutputPath + ".tmp";
+	{
+		std::ofstream File(TemporaryPath, std::ios::binary | std::ios::trunc);
+		AssetArchiveHeader Header;
+		std::memcpy(Header.Magic, AssetArchiveMagic, sizeof(Header.Magic));
+		Header.Version = AssetArchiveVersion;
+		Header.EntryCount = static_cast<uint32_t>(Files.size());
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+		File.write(reinterpret_cast<const char*>(Table.data()), static_cast<std::streamsize>(sizeof(AssetArchiveEntry) * Table.size()));
+		for (const PackedFile& Packed : Files)
+		{
+			File.write(Packed.Path.data(), static_cast<std::streamsize>(Packed.Path.size()));
+		}
+		for (size_t i = 0; i < Files.size(); ++i)
+		{
+			const std::vector<char> Padding(Table[i].DataOffset - static_cast<uint64_t>(File.tellp()), 0);
+			File.write(Padding.data(), static_cast<std::streamsize>(Padding.size()));
+			File.write(reinterpret_cast<const char*>(Files[i].Data.data()), static_cast<std::streamsize>(Files[i].Data.size()));
+		}
+		if (!File)
+		{
+			return false;
+		}
+	}
+
+	std::filesystem::rename(TemporaryPath, OutputPath, Error);
+	return !Error;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "Usage: %s <level script> <output archive>\n", argv[0]);
+		return 1;
+	}
+	const std::string ScriptPath = argv[1];
+	const std::string OutputPath = argv[2];
+
+	// Level scripts only touch engine bindings from inside callbacks, so the standard libraries suffice.
+	sol::state LuaState;
+	LuaState.open_libraries(sol::lib::base, sol::lib::math, sol::lib::os, sol::lib::string, sol::lib::table);
+	sol::protected_function_result Result = LuaState.safe_script_file(ScriptPath, sol::script_pass_on_error);
+	if (!Result.valid())
+	{
+		sol::error Error = Result;
+		std::fprintf(stderr, "Could not run %s: %s\n", ScriptPath.c_str(), Error.what());
+		return 1;
+	}
+
+	std::vector<PackedFile> Files;
+	std::set<std::string> PackedPaths;
+	const auto AddFile = [&Files, &PackedPaths](ArchiveEntryType Type, const std::string& FilePath)
+	{
+		PackedFile Packed;
+		Packed.Type = Type;
+		Packed.Path = NormalizeArchivePath(FilePath);
+		if (!PackedPaths.insert(Packed.Path).second)
+		{
+			return true;
+		}
+
+		Packed.SourceHash = HashFile(FilePath, 0);
+		const bool IsPacked = Type == ArchiveEntryType::Texture ? PackTexture(FilePath, Packed) : ReadWholeFile(FilePath, Packed.Data);
+		if (!IsPacked)
+		{
+			std::fprintf(stderr, "Could not pack %s\n", FilePath.c_str());
+			return false;
+		}
+		Files.push_back(std::move(Packed));
+		return true;
+	};
+
+	bool IsComplete = AddFile(ArchiveEntryType::Script, ScriptPath);
+	sol::table Assets = LuaState["Level"]["assets"];
+	for (uint16_t i = 0; ; ++i)
+	{
+		sol::optional<sol::table> Asset = Assets[i];
+		if (!Asset)
+		{
+			break;
+		}
+
+		const std::string AssetType = (*Asset)["type"];
+		if (AssetType == "texture")
+		{
+			IsComplete = AddFile(ArchiveEntryType::Texture, (*Asset)["file"]) && IsComplete;
+		}
+		else if (AssetType == "font")
+		{
+			IsComplete = AddFile(ArchiveEntryType::Font, (*Asset)["file"]) && IsComplete;
+		}
+		else if (AssetType == "sound")
+		{
+			IsComplete = AddFile(ArchiveEntryType::Sound, (*Asset)["file"]) && IsComplete;
+		}
+	}
+
+	if (!IsComplete || !WriteArchive(OutputPath, Files))
+	{
+		std::fprintf(stderr, "Could not write %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	std::printf("Packed %zu files into %s (%llu KB)\n", Files.size(), OutputPath.c_str(), static_cast<unsigned long long>(std::filesystem::file_size(OutputPath) / 1024));
+	return 0;
+}